@@ -0,0 +1,197 @@
+/*
+ * Benchmark di buffer_t: P produttori e C consumatori si scambiano N
+ * messaggi con put_bloccante/get_bloccante; riporta throughput e
+ * cambi di contesto (volontari + involontari) per messaggio.
+ *
+ * Confronto tra i due backend di sincronizzazione:
+ *   gcc -O2 -pthread bench_buffer.c buffer.c message.c mem_alloc.c msg_pool.c -o bench_pthread
+ *   gcc -O2 -pthread -DBUFFER_FUTEX bench_buffer.c buffer.c message.c mem_alloc.c msg_pool.c -o bench_futex
+ *   ./bench_pthread [opzioni] [P] [C] [N] [dim. buffer]
+ *   ./bench_futex   [opzioni] [P] [C] [N] [dim. buffer]
+ *
+ * Opzioni NUMA / huge pages:
+ *   -P nodo   vincola i produttori alle CPU del nodo
+ *   -C nodo   vincola i consumatori alle CPU del nodo
+ *   -m nodo   alloca buffer e messaggi (da un msg_pool_t) sul nodo
+ *   -i        distribuisce buffer e messaggi su tutti i nodi
+ *   -H thp    usa transparent huge pages, -H huge huge pages riservate
+ * numa_fallbacks conta le allocazioni rimaste senza vincolo NUMA.
+ * Ad esempio, consumatori remoti rispetto alla memoria su un dual socket:
+ *   ./bench_futex -P 0 -C 1 -m 0 8 8 10000000 4096
+ *
+ * Latenze di attesa ed elaborazione (aggiungere -DBUFFER_TRACE e trace.c):
+ *   -s n      campiona un messaggio ogni n e riporta i percentili
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "buffer.h"
+#include "message.h"
+#include "mem_alloc.h"
+#include "msg_pool.h"
+
+#define BENCH_MAX_CPUS 1024
+
+typedef struct {
+    buffer_t* buffer;
+    msg_pool_t* pool;    // NULL: messaggi allocati con msg_init_string
+    long num_ops;
+    int node;            // nodo NUMA a cui vincolare il thread, MEM_ANY_NODE se nessuno
+} bench_data_t;
+
+// Vincola il thread corrente alle CPU del nodo
+static void pin_to_node(int node) {
+    int cpus[BENCH_MAX_CPUS];
+    int count = mem_node_cpus(node, cpus, BENCH_MAX_CPUS);
+    cpu_set_t set;
+
+    if (count <= 0) {
+        fprintf(stderr, "NUMA node %d not found, thread not pinned\n", node);
+        return;
+    }
+
+    CPU_ZERO(&set);
+    for (int i = 0; i < count; i++) {
+        CPU_SET(cpus[i], &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void* bench_producer(void* arg) {
+    bench_data_t* data = (bench_data_t*) arg;
+    if (data->node != MEM_ANY_NODE) {
+        pin_to_node(data->node);
+    }
+    for (long i = 0; i < data->num_ops; i++) {
+        msg_t* msg = data->pool != NULL ? msg_pool_init_string(data->pool, "BENCH") : msg_init_string("BENCH");
+        put_bloccante(data->buffer, msg);
+    }
+    return NULL;
+}
+
+static void* bench_consumer(void* arg) {
+    bench_data_t* data = (bench_data_t*) arg;
+    if (data->node != MEM_ANY_NODE) {
+        pin_to_node(data->node);
+    }
+    for (long i = 0; i < data->num_ops; i++) {
+        msg_t* msg = get_bloccante(data->buffer);
+        msg->msg_destroy(msg);
+    }
+    return NULL;
+}
+
+// Cambi di contesto del processo, volontari ed involontari
+static long context_switches(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+int main(int argc, char** argv) {
+    unsigned long numa_fallbacks = 0;
+    mem_alloc_opts_t opts = { MEM_ANY_NODE, false, MEM_HUGEPAGES_NONE, &numa_fallbacks };
+    bool use_opts = false;
+    int producer_node = MEM_ANY_NODE;
+    int consumer_node = MEM_ANY_NODE;
+    int opt;
+
+#ifdef BUFFER_TRACE
+    while ((opt = getopt(argc, argv, "P:C:m:iH:s:")) != -1) {
+#else
+    while ((opt = getopt(argc, argv, "P:C:m:iH:")) != -1) {
+#endif
+        switch (opt) {
+        case 'P': producer_node = atoi(optarg); break;
+        case 'C': consumer_node = atoi(optarg); break;
+        case 'm': opts.numa_node = atoi(optarg); use_opts = true; break;
+        case 'i': opts.interleave = true; use_opts = true; break;
+        case 'H':
+            opts.hugepages = strcmp(optarg, "huge") == 0 ? MEM_HUGEPAGES_EXPLICIT : MEM_HUGEPAGES_TRANSPARENT;
+            use_opts = true;
+            break;
+#ifdef BUFFER_TRACE
+        case 's': trace_set_sampling((unsigned int) atoi(optarg)); break;
+#endif
+        default:
+            fprintf(stderr, "usage: %s [-P node] [-C node] [-m node | -i] [-H thp|huge] [P] [C] [N] [size]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int producers = argc > optind ? atoi(argv[optind]) : 4;
+    int consumers = argc > optind + 1 ? atoi(argv[optind + 1]) : 4;
+    long messages = argc > optind + 2 ? atol(argv[optind + 2]) : 1000000;
+    unsigned int size = argc > optind + 3 ? (unsigned int) atoi(argv[optind + 3]) : 16;
+
+    // Ogni thread scambia la stessa quota di messaggi
+    messages -= messages % ((long) producers * consumers);
+
+    // Messaggi vivi al più: quelli nel buffer più uno per thread
+    buffer_t* buffer = use_opts ? buffer_init_opts(size, &opts) : buffer_init(size);
+    msg_pool_t* pool = use_opts ? msg_pool_init(size + producers + consumers, 16, &opts) : NULL;
+    pthread_t* tids = (pthread_t*) malloc(sizeof(pthread_t) * (producers + consumers));
+    bench_data_t producer_data = { buffer, pool, messages / producers, producer_node };
+    bench_data_t consumer_data = { buffer, pool, messages / consumers, consumer_node };
+
+    struct timespec begin, end;
+    long switches = context_switches();
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for (int i = 0; i < producers; i++) {
+        pthread_create(&tids[i], NULL, bench_producer, &producer_data);
+    }
+    for (int i = 0; i < consumers; i++) {
+        pthread_create(&tids[producers + i], NULL, bench_consumer, &consumer_data);
+    }
+    for (int i = 0; i < producers + consumers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    switches = context_switches() - switches;
+
+    double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+    printf("backend=%s P=%d C=%d N=%ld size=%u time=%.3fs throughput=%.0f msg/s ctxsw/msg=%.3f",
+           BUFFER_SYNC_BACKEND, producers, consumers, messages, size, seconds,
+           messages / seconds, (double) switches / messages);
+    if (use_opts) {
+        if (opts.interleave) {
+            printf(" memory=interleave");
+        } else {
+            printf(" memory=node%d", opts.numa_node);
+        }
+        printf(" numa_fallbacks=%lu hugepages=%s pool_fallbacks=%lu", numa_fallbacks,
+               opts.hugepages == MEM_HUGEPAGES_EXPLICIT ? "huge" : opts.hugepages == MEM_HUGEPAGES_TRANSPARENT ? "thp" : "none",
+               pool->fallbacks);
+    }
+    printf(" producers@%d consumers@%d\n", producer_node, consumer_node);
+
+#ifdef BUFFER_TRACE
+    trace_snapshot_t snapshot;
+    buffer_trace_snapshot(buffer, &snapshot);
+    printf("samples=%llu queueing p50=%lluns p99=%lluns max=%lluns processing p50=%lluns p99=%lluns max=%lluns\n",
+           (unsigned long long) snapshot.queueing.count,
+           (unsigned long long) trace_percentile(&snapshot.queueing, 50),
+           (unsigned long long) trace_percentile(&snapshot.queueing, 99),
+           (unsigned long long) snapshot.queueing.max_ns,
+           (unsigned long long) trace_percentile(&snapshot.processing, 50),
+           (unsigned long long) trace_percentile(&snapshot.processing, 99),
+           (unsigned long long) snapshot.processing.max_ns);
+#endif
+
+    buffer_destroy(buffer);
+    if (pool != NULL) {
+        msg_pool_destroy(pool);
+    }
+    free(tids);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * Benchmark di msg_batch_t: crea N messaggi stringa da un unico blocco
+ * di stringhe separate da \0 e li distrugge, confrontando
+ *  - msg_init_string / msg_destroy_string per ogni messaggio;
+ *  - msg_batch_init_strings / msg_batch_release per tutto il blocco
+ *    (rilascio in blocco, senza distruggere i messaggi);
+ *  - msg_batch_init_strings / msg_batch_detach e msg_destroy per ogni
+ *    messaggio, come farebbero i consumatori di un buffer.
+ *
+ *   gcc -O2 -pthread bench_msg_batch.c msg_batch.c message.c -o bench_msg_batch
+ *   ./bench_msg_batch [N] [lunghezza media] [ripetizioni]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "message.h"
+#include "msg_batch.h"
+
+static double now_s(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int messages = argc > 1 ? atoi(argv[1]) : 50000;
+    int average = argc > 2 ? atoi(argv[2]) : 24;
+    int rounds = argc > 3 ? atoi(argv[3]) : 50;
+
+    // Stringhe di lunghezza tra average/2 e 3*average/2
+    char* packed = (char*) malloc((size_t) messages * (2 * average + 1));
+    size_t length = 0;
+    for (int i = 0; i < messages; i++) {
+        int string_length = average / 2 + rand() % (average + 1);
+        for (int j = 0; j < string_length; j++) {
+            packed[length++] = (char) ('a' + rand() % 26);
+        }
+        packed[length++] = '\0';
+    }
+
+    msg_t** msgs = (msg_t**) malloc(sizeof(msg_t*) * messages);
+    unsigned long checksum = 0;
+
+    double begin = now_s();
+    for (int r = 0; r < rounds; r++) {
+        const char* string = packed;
+        for (int i = 0; i < messages; i++) {
+            msgs[i] = msg_init_string((void*) string);
+            string += strlen(string) + 1;
+        }
+        for (int i = 0; i < messages; i++) {
+            checksum += (unsigned char) ((char*) msgs[i]->content)[0];
+            msgs[i]->msg_destroy(msgs[i]);
+        }
+    }
+    double single = (now_s() - begin) / ((double) rounds * messages);
+
+    begin = now_s();
+    for (int r = 0; r < rounds; r++) {
+        msg_batch_t* batch = msg_batch_init_strings(packed, length);
+        for (unsigned int i = 0; i < batch->count; i++) {
+            checksum += (unsigned char) ((char*) msg_batch_msg(batch, i)->content)[0];
+        }
+        msg_batch_release(batch);
+    }
+    double batched = (now_s() - begin) / ((double) rounds * messages);
+
+    begin = now_s();
+    for (int r = 0; r < rounds; r++) {
+        msg_batch_t* batch = msg_batch_init_strings(packed, length);
+        unsigned int count = batch->count;
+        for (unsigned int i = 0; i < count; i++) {
+            msgs[i] = msg_batch_msg(batch, i);
+        }
+        msg_batch_detach(batch); // La distruzione dell'ultimo messaggio dealloca il lotto
+        for (unsigned int i = 0; i < count; i++) {
+            checksum += (unsigned char) ((char*) msgs[i]->content)[0];
+            msgs[i]->msg_destroy(msgs[i]);
+        }
+    }
+    double detached = (now_s() - begin) / ((double) rounds * messages);
+
+    printf("N=%d avg_length=%d single=%.1fns/msg batch_release=%.1fns/msg (%.1fx) "
+           "batch_destroy=%.1fns/msg (%.1fx) (checksum %lu)\n",
+           messages, average, single * 1e9, batched * 1e9, single / batched,
+           detached * 1e9, single / detached, checksum);
+
+    free(msgs);
+    free(packed);
+    return 0;
+}
@@ -1,24 +1,176 @@
-#include <pthread.h> 
 #include <stdbool.h> 
 #include <stdio.h>   
 #include <stdlib.h>  
 #include "buffer.h"  
 
+// Marca l'istante di inserimento del messaggio in posizione slot, se campionato (mutex acquisito)
+static inline void traccia_inserimento(buffer_t* buffer, unsigned int slot) {
+#ifdef BUFFER_TRACE
+    buffer->trace_stamps[slot] = trace_enqueue();
+#else
+    (void) buffer;
+    (void) slot;
+#endif
+}
+
+// Registra l'attesa del messaggio estratto dalla posizione slot, se campionato (mutex acquisito)
+static inline void traccia_estrazione(buffer_t* buffer, unsigned int slot, msg_t* msg) {
+#ifdef BUFFER_TRACE
+    trace_dequeue(&buffer->trace, &buffer->trace_stamps[slot], msg);
+#else
+    (void) buffer;
+    (void) slot;
+    (void) msg;
+#endif
+}
+
+// Accoda una operazione asincrona in fondo ad una lista
+static void accoda_attesa(buffer_waiter_t** head, buffer_waiter_t** tail, buffer_waiter_t* waiter) {
+    waiter->next = NULL;
+    if (*tail != NULL) {
+        (*tail)->next = waiter;
+    } else {
+        *head = waiter;
+    }
+    *tail = waiter;
+}
+
+// Estrae la prima operazione asincrona di una lista non vuota
+static buffer_waiter_t* estrai_attesa(buffer_waiter_t** head, buffer_waiter_t** tail) {
+    buffer_waiter_t* waiter = *head;
+    *head = waiter->next;
+    if (*head == NULL) {
+        *tail = NULL;
+    }
+    return waiter;
+}
+
+// Completa le operazioni asincrone sospese finché lo stato del buffer lo
+// consente e sposta le loro continuazioni nella lista ready (mutex acquisito)
+static void servi_attese(buffer_t* buffer, buffer_waiter_t** ready, buffer_waiter_t** ready_tail) {
+    bool progress = true;
+
+    while (progress) {
+        progress = false;
+
+        // Una get sospesa può prendere un messaggio
+        if (buffer->get_waiters != NULL && buffer->current_size > 0) {
+            buffer_waiter_t* waiter = estrai_attesa(&buffer->get_waiters, &buffer->get_waiters_tail);
+            buffer->current_size--;
+            waiter->msg = buffer->messages[buffer->current_size];
+            traccia_estrazione(buffer, buffer->current_size, waiter->msg);
+            accoda_attesa(ready, ready_tail, waiter);
+            sync_cond_signal(&buffer->is_not_full, &buffer->mutex); // Segnala che non è più pieno
+            progress = true;
+        }
+
+        // Una put sospesa può inserire il suo messaggio
+        if (buffer->put_waiters != NULL && buffer->current_size < buffer->max_size) {
+            buffer_waiter_t* waiter = estrai_attesa(&buffer->put_waiters, &buffer->put_waiters_tail);
+            buffer->messages[buffer->current_size] = waiter->msg;
+            traccia_inserimento(buffer, buffer->current_size);
+            buffer->current_size++;
+            accoda_attesa(ready, ready_tail, waiter);
+            sync_cond_signal(&buffer->is_not_empty, &buffer->mutex); // Segnala che non è più vuoto
+            progress = true;
+        }
+    }
+}
+
+// Continuazioni del thread in attesa di essere eseguite in linea: quelle
+// sbloccate da una continuazione attendono il suo ritorno invece di annidarsi
+static _Thread_local buffer_waiter_t* trampoline_head = NULL;
+static _Thread_local buffer_waiter_t* trampoline_tail = NULL;
+static _Thread_local bool trampoline_active = false;
+
+// Esegue le continuazioni pronte, in linea o tramite l'esecutore (mutex rilasciato)
+static void esegui_pronte(buffer_waiter_t* ready, buffer_waiter_t* ready_tail, buffer_executor_t executor, void* executor_arg) {
+    if (executor != NULL) {
+        while (ready != NULL) {
+            buffer_waiter_t* waiter = ready;
+            ready = ready->next;
+            executor(executor_arg, waiter->callback, waiter->msg, waiter->arg);
+            free(waiter);
+        }
+        return;
+    }
+
+    if (ready == NULL) {
+        return;
+    }
+    if (trampoline_tail != NULL) {
+        trampoline_tail->next = ready;
+    } else {
+        trampoline_head = ready;
+    }
+    trampoline_tail = ready_tail;
+
+    // Dentro una continuazione: le eseguirà il ciclo più esterno
+    if (trampoline_active) {
+        return;
+    }
+
+    trampoline_active = true;
+    while (trampoline_head != NULL) {
+        buffer_waiter_t* waiter = estrai_attesa(&trampoline_head, &trampoline_tail);
+        waiter->callback(waiter->msg, waiter->arg);
+        free(waiter);
+    }
+    trampoline_active = false;
+}
+
+// Serve le attese, rilascia il mutex ed esegue le continuazioni pronte
+static void sblocca_e_servi(buffer_t* buffer) {
+    buffer_waiter_t* ready = NULL;
+    buffer_waiter_t* ready_tail = NULL;
+
+    servi_attese(buffer, &ready, &ready_tail);
+    buffer_executor_t executor = buffer->executor;
+    void* executor_arg = buffer->executor_arg;
+    sync_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    esegui_pronte(ready, ready_tail, executor, executor_arg);
+}
+
 // Inizializza un buffer thread-safe
 buffer_t* buffer_init(unsigned int max_size){
+    return buffer_init_opts(max_size, NULL);
+}
+
+// Inizializza un buffer thread-safe con memoria vincolata secondo opts
+buffer_t* buffer_init_opts(unsigned int max_size, const mem_alloc_opts_t* opts){
     buffer_t* buffer = (buffer_t*) malloc(sizeof(buffer_t));
-    buffer->messages = (msg_t**) malloc(sizeof(msg_t*) * max_size);
+    buffer->messages_mapped = opts != NULL;
+    if (buffer->messages_mapped) {
+        buffer->messages = (msg_t**) mem_alloc(sizeof(msg_t*) * max_size, opts);
+        if (buffer->messages == NULL) {
+            perror("Buffer memory allocation failed!");
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        buffer->messages = (msg_t**) malloc(sizeof(msg_t*) * max_size);
+    }
     buffer->max_size = max_size;
     buffer->current_size = 0;
+    buffer->put_waiters = NULL;
+    buffer->put_waiters_tail = NULL;
+    buffer->get_waiters = NULL;
+    buffer->get_waiters_tail = NULL;
+    buffer->executor = NULL;
+    buffer->executor_arg = NULL;
+#ifdef BUFFER_TRACE
+    buffer->trace_stamps = (uint64_t*) calloc(max_size, sizeof(uint64_t));
+    trace_init(&buffer->trace);
+#endif
 
     // Inizializza mutex per accesso esclusivo
-    if (pthread_mutex_init(&buffer->mutex, NULL) != 0) {
+    if (sync_mutex_init(&buffer->mutex) != 0) {
         perror("Mutex initialization failed!");
         exit(EXIT_FAILURE);
     }
 
     // Inizializza variabili di condizione per segnalazione pieno/vuoto
-    if (pthread_cond_init(&buffer->is_not_full, NULL) != 0 || pthread_cond_init(&buffer->is_not_empty, NULL) != 0) {
+    if (sync_cond_init(&buffer->is_not_full) != 0 || sync_cond_init(&buffer->is_not_empty) != 0) {
         perror("Condition variables initialization failed!");
         exit(EXIT_FAILURE);
     }
@@ -36,27 +188,50 @@ void buffer_destroy(buffer_t* buffer) {
         }
     }
 
-    free(buffer->messages);
-    pthread_mutex_destroy(&buffer->mutex); // Distrugge il mutex
-    pthread_cond_destroy(&buffer->is_not_full); // Distrugge is_not_full
-    pthread_cond_destroy(&buffer->is_not_empty); // Distrugge is_not_empty
+    // Le put asincrone mai completate cedono comunque il messaggio al buffer
+    while (buffer->put_waiters != NULL) {
+        buffer_waiter_t* waiter = estrai_attesa(&buffer->put_waiters, &buffer->put_waiters_tail);
+        waiter->msg->msg_destroy(waiter->msg);
+        free(waiter);
+    }
+
+    // Le get asincrone mai completate ricevono BUFFER_ERROR, direttamente in linea
+    while (buffer->get_waiters != NULL) {
+        buffer_waiter_t* waiter = estrai_attesa(&buffer->get_waiters, &buffer->get_waiters_tail);
+        waiter->callback(BUFFER_ERROR, waiter->arg);
+        free(waiter);
+    }
+
+    if (buffer->messages_mapped) {
+        mem_free(buffer->messages);
+    } else {
+        free(buffer->messages);
+    }
+#ifdef BUFFER_TRACE
+    free(buffer->trace_stamps);
+    trace_destroy(&buffer->trace);
+#endif
+    sync_mutex_destroy(&buffer->mutex); // Distrugge il mutex
+    sync_cond_destroy(&buffer->is_not_full); // Distrugge is_not_full
+    sync_cond_destroy(&buffer->is_not_empty); // Distrugge is_not_empty
     free(buffer);
 }
 
 // Inserisce un messaggio, bloccante se il buffer è pieno
 msg_t* put_bloccante(buffer_t* buffer, msg_t* msg) {
     if (msg != NULL) {
-        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+        sync_mutex_lock(&buffer->mutex); // Blocca l'accesso
 
         // Attende finché il buffer non è più pieno
         while (buffer->current_size >= buffer->max_size) {
-            pthread_cond_wait(&buffer->is_not_full, &buffer->mutex); 
+            sync_cond_wait(&buffer->is_not_full, &buffer->mutex); 
         }
 
         buffer->messages[buffer->current_size] = msg;
+        traccia_inserimento(buffer, buffer->current_size);
         buffer->current_size++;
-        pthread_cond_signal(&buffer->is_not_empty); // Segnala che non è più vuoto
-        pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+        sync_cond_signal(&buffer->is_not_empty, &buffer->mutex); // Segnala che non è più vuoto
+        sblocca_e_servi(buffer); // Sblocca l'accesso e serve le get asincrone
     }
 
     return msg;
@@ -65,15 +240,16 @@ msg_t* put_bloccante(buffer_t* buffer, msg_t* msg) {
 // Inserisce un messaggio, non bloccante (fallisce se il buffer è pieno)
 msg_t* put_non_bloccante(buffer_t* buffer, msg_t* msg) {
     if (msg != NULL) {
-        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+        sync_mutex_lock(&buffer->mutex); // Blocca l'accesso
 
         if (buffer->current_size < buffer->max_size) { // Se c'è spazio
             buffer->messages[buffer->current_size] = msg;
+            traccia_inserimento(buffer, buffer->current_size);
             buffer->current_size++;
-            pthread_cond_signal(&buffer->is_not_empty); // Segnala che non è più vuoto
-            pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+            sync_cond_signal(&buffer->is_not_empty, &buffer->mutex); // Segnala che non è più vuoto
+            sblocca_e_servi(buffer); // Sblocca l'accesso e serve le get asincrone
         } else {
-            pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+            sync_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
             return BUFFER_ERROR; 
         }
     }
@@ -83,36 +259,85 @@ msg_t* put_non_bloccante(buffer_t* buffer, msg_t* msg) {
 
 // Estrae un messaggio, bloccante se il buffer è vuoto
 msg_t* get_bloccante(buffer_t* buffer) {
-    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+    sync_mutex_lock(&buffer->mutex); // Blocca l'accesso
 
     // Attende finché il buffer non è più vuoto
     while (buffer->current_size <= 0) {
-        pthread_cond_wait(&buffer->is_not_empty, &buffer->mutex);
+        sync_cond_wait(&buffer->is_not_empty, &buffer->mutex);
     }
     buffer->current_size--;
     msg_t* msg = buffer->messages[buffer->current_size];
+    traccia_estrazione(buffer, buffer->current_size, msg);
     
-    pthread_cond_signal(&buffer->is_not_full); // Segnala che non è più pieno
+    sync_cond_signal(&buffer->is_not_full, &buffer->mutex); // Segnala che non è più pieno
 
-    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+    sblocca_e_servi(buffer); // Sblocca l'accesso e serve le put asincrone
     
     return msg;
 }
 
 // Estrae un messaggio, non bloccante (fallisce se il buffer è vuoto)
 msg_t* get_non_bloccante(buffer_t* buffer) {
-    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+    sync_mutex_lock(&buffer->mutex); // Blocca l'accesso
 
     if (buffer->current_size <= 0) { // Se è vuoto
-        pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+        sync_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
         return BUFFER_ERROR;
     }
     buffer->current_size--;
     msg_t* msg = buffer->messages[buffer->current_size];
+    traccia_estrazione(buffer, buffer->current_size, msg);
     
-    pthread_cond_signal(&buffer->is_not_full); // Segnala che non è più pieno
+    sync_cond_signal(&buffer->is_not_full, &buffer->mutex); // Segnala che non è più pieno
 
-    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+    sblocca_e_servi(buffer); // Sblocca l'accesso e serve le put asincrone
     
     return msg;
-}
\ No newline at end of file
+}
+
+// Inserisce un messaggio senza mai sospendere il chiamante
+msg_t* put_asincrona(buffer_t* buffer, msg_t* msg, buffer_callback_t callback, void* arg) {
+    if (msg != NULL) {
+        buffer_waiter_t* waiter = (buffer_waiter_t*) malloc(sizeof(buffer_waiter_t));
+        waiter->msg = msg;
+        waiter->callback = callback;
+        waiter->arg = arg;
+
+        sync_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+        // Accoda dietro alle put già sospese; se c'è spazio viene servita subito
+        accoda_attesa(&buffer->put_waiters, &buffer->put_waiters_tail, waiter);
+        sblocca_e_servi(buffer);
+    }
+
+    return msg;
+}
+
+// Estrae un messaggio senza mai sospendere il chiamante
+void get_asincrona(buffer_t* buffer, buffer_callback_t callback, void* arg) {
+    buffer_waiter_t* waiter = (buffer_waiter_t*) malloc(sizeof(buffer_waiter_t));
+    waiter->msg = NULL;
+    waiter->callback = callback;
+    waiter->arg = arg;
+
+    sync_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+    // Accoda dietro alle get già sospese; se il buffer non è vuoto viene servita subito
+    accoda_attesa(&buffer->get_waiters, &buffer->get_waiters_tail, waiter);
+    sblocca_e_servi(buffer);
+}
+
+// Imposta l'esecutore delle continuazioni asincrone
+void buffer_set_executor(buffer_t* buffer, buffer_executor_t executor, void* executor_arg) {
+    sync_mutex_lock(&buffer->mutex);
+    buffer->executor = executor;
+    buffer->executor_arg = executor_arg;
+    sync_mutex_unlock(&buffer->mutex);
+}
+
+#ifdef BUFFER_TRACE
+// Somma le latenze registrate da tutti i thread
+void buffer_trace_snapshot(buffer_t* buffer, trace_snapshot_t* snapshot) {
+    trace_merge(&buffer->trace, snapshot);
+}
+#endif
\ No newline at end of file
@@ -1,18 +1,51 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 
-#include <pthread.h>
+#include <stdbool.h>
+#include "mem_alloc.h"
 #include "message.h" 
+#include "sync.h"
+#include "trace.h"
 
 #define BUFFER_ERROR (msg_t *) NULL
 
+// continuazione di una operazione asincrona: riceve il messaggio
+// inserito (put) o estratto (get) ed il contesto arg dell'utente;
+// N.B.: per una put msg identifica soltanto il messaggio inserito, che
+// appartiene ormai al buffer e può essere già stato estratto e distrutto
+// da un consumatore: non va dereferenziato
+typedef void (*buffer_callback_t)(msg_t* msg, void* arg);
+
+// esecutore delle continuazioni: se impostato, riceve le continuazioni
+// pronte invece di eseguirle direttamente nel thread che le ha sbloccate
+typedef void (*buffer_executor_t)(void* executor_arg, buffer_callback_t callback, msg_t* msg, void* arg);
+
+// operazione asincrona sospesa in attesa di spazio (put) o di un messaggio (get)
+typedef struct buffer_waiter {
+    msg_t* msg;
+    buffer_callback_t callback;
+    void* arg;
+    struct buffer_waiter* next;
+} buffer_waiter_t;
+
 typedef struct buffer {
 	msg_t **messages;
+    bool messages_mapped;              // messages ottenuto con mem_alloc invece che con malloc
     unsigned int max_size;
     unsigned int current_size;
-    pthread_mutex_t mutex;
-    pthread_cond_t is_not_full;
-    pthread_cond_t is_not_empty;
+    sync_mutex_t mutex;                // pthread, oppure futex con -DBUFFER_FUTEX (vedi sync.h)
+    sync_cond_t is_not_full;
+    sync_cond_t is_not_empty;
+    buffer_waiter_t* put_waiters;      // put asincrone sospese, in ordine di arrivo
+    buffer_waiter_t* put_waiters_tail;
+    buffer_waiter_t* get_waiters;      // get asincrone sospese, in ordine di arrivo
+    buffer_waiter_t* get_waiters_tail;
+    buffer_executor_t executor;        // NULL: continuazioni eseguite in linea
+    void* executor_arg;
+#ifdef BUFFER_TRACE
+    uint64_t* trace_stamps;            // istante di inserimento dei messaggi campionati, per posizione
+    trace_t trace;                     // latenze dei messaggi (vedi trace.h)
+#endif
 } buffer_t;
 
 /* allocazione / deallocazione buffer */
@@ -20,6 +53,10 @@ typedef struct buffer {
 // creazione di un buffer vuoto di dim. max nota
 buffer_t* buffer_init(unsigned int maxsize);
 
+// creazione di un buffer vuoto la cui memoria per i messaggi è
+// allocata secondo opts (nodo NUMA, interleave, huge pages)
+buffer_t* buffer_init_opts(unsigned int maxsize, const mem_alloc_opts_t* opts);
+
 // deallocazione di un buffer
 void buffer_destroy(buffer_t* buffer);
 
@@ -43,4 +80,34 @@ msg_t* get_bloccante(buffer_t* buffer);
 // ed il valore estratto in caso contrario
 msg_t* get_non_bloccante(buffer_t* buffer);
 
+/* operazioni asincrone: non sospendono mai il thread chiamante */
+
+// inserimento asincrono: se il buffer è pieno accoda la richiesta e
+// ritorna subito; callback(msg, arg) viene invocata non appena il
+// messaggio è stato inserito (anche subito, se c'è spazio)
+// restituisce il messaggio accodato; N.B.: msg!=null, e dopo il
+// ritorno msg può essere già stato consumato (vedi buffer_callback_t)
+msg_t* put_asincrona(buffer_t* buffer, msg_t* msg, buffer_callback_t callback, void* arg);
+
+// estrazione asincrona: se il buffer è vuoto accoda la richiesta e
+// ritorna subito; callback(msg, arg) riceve il messaggio estratto
+// non appena disponibile (anche subito, se il buffer non è vuoto),
+// oppure BUFFER_ERROR se il buffer viene distrutto prima
+void get_asincrona(buffer_t* buffer, buffer_callback_t callback, void* arg);
+
+// imposta l'esecutore delle continuazioni asincrone; con executor
+// NULL le continuazioni vengono eseguite nel thread che le sblocca, una
+// dopo l'altra: quelle sbloccate da una continuazione (ad esempio una
+// get_asincrona rilanciata) vengono eseguite dopo il suo ritorno, senza
+// annidare chiamate
+void buffer_set_executor(buffer_t* buffer, buffer_executor_t executor, void* executor_arg);
+
+#ifdef BUFFER_TRACE
+/* tracciamento delle latenze (vedi trace.h) */
+
+// latenze di attesa ed elaborazione dei messaggi campionati del buffer,
+// sommate su tutti i thread; non sospende produttori e consumatori
+void buffer_trace_snapshot(buffer_t* buffer, trace_snapshot_t* snapshot);
+#endif
+
 #endif // BUFFER_H
\ No newline at end of file
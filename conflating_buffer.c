@@ -0,0 +1,208 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "conflating_buffer.h"
+
+// Bucket iniziale della chiave nella tabella hash
+static unsigned int bucket_di(conflating_buffer_t* buffer, unsigned long key) {
+    unsigned long long hash = (unsigned long long) key * 11400714819323198485ULL;
+    return (unsigned int) (hash >> 32) & buffer->index_mask;
+}
+
+// Cerca il bucket della chiave; se assente restituisce il primo bucket libero
+static unsigned int cerca_bucket(conflating_buffer_t* buffer, unsigned long key) {
+    unsigned int b = bucket_di(buffer, key);
+
+    while (buffer->index[b] != 0 && buffer->keys[buffer->index[b] - 1] != key) {
+        b = (b + 1) & buffer->index_mask;
+    }
+
+    return b;
+}
+
+// Rimuove il bucket b ricompattando la sequenza di probing che lo segue
+static void rimuovi_bucket(conflating_buffer_t* buffer, unsigned int b) {
+    unsigned int next = (b + 1) & buffer->index_mask;
+
+    while (buffer->index[next] != 0) {
+        unsigned int home = bucket_di(buffer, buffer->keys[buffer->index[next] - 1]);
+
+        // L'elemento può occupare b solo se b non precede il suo bucket iniziale
+        if (((next - home) & buffer->index_mask) >= ((next - b) & buffer->index_mask)) {
+            buffer->index[b] = buffer->index[next];
+            b = next;
+        }
+        next = (next + 1) & buffer->index_mask;
+    }
+
+    buffer->index[b] = 0;
+}
+
+// Sostituisce o accoda il messaggio (mutex acquisito); restituisce il
+// messaggio sostituito, da distruggere fuori dalla sezione critica
+static msg_t* inserisci(conflating_buffer_t* buffer, unsigned int b, unsigned long key, msg_t* msg) {
+    if (buffer->index[b] != 0) {
+        unsigned int pos = buffer->index[b] - 1;
+        msg_t* old = buffer->messages[pos];
+        buffer->messages[pos] = msg; // Stessa posizione in coda
+        buffer->conflated++;
+        return old != msg ? old : NULL;
+    }
+
+    unsigned int pos = (buffer->head + buffer->current_size) % buffer->max_size;
+    buffer->messages[pos] = msg;
+    buffer->keys[pos] = key;
+    buffer->index[b] = pos + 1;
+    buffer->current_size++;
+    pthread_cond_signal(&buffer->is_not_empty); // Segnala che non è più vuoto
+
+    return NULL;
+}
+
+// Estrae il messaggio più vecchio (mutex acquisito, buffer non vuoto)
+static msg_t* estrai(conflating_buffer_t* buffer) {
+    unsigned int pos = buffer->head;
+    msg_t* msg = buffer->messages[pos];
+
+    rimuovi_bucket(buffer, cerca_bucket(buffer, buffer->keys[pos]));
+    buffer->head = (buffer->head + 1) % buffer->max_size;
+    buffer->current_size--;
+    pthread_cond_signal(&buffer->is_not_full); // Segnala che non è più pieno
+
+    return msg;
+}
+
+// Inizializza un buffer con sostituzione per chiave
+conflating_buffer_t* conflating_buffer_init(unsigned int max_size) {
+    conflating_buffer_t* buffer = (conflating_buffer_t*) malloc(sizeof(conflating_buffer_t));
+    buffer->messages = (msg_t**) malloc(sizeof(msg_t*) * max_size);
+    buffer->keys = (unsigned long*) malloc(sizeof(unsigned long) * max_size);
+    buffer->max_size = max_size;
+    buffer->head = 0;
+    buffer->current_size = 0;
+    buffer->conflated = 0;
+
+    // Tabella hash con fattore di carico al più 1/2
+    unsigned int index_size = 2;
+    while (index_size < 2 * max_size) {
+        index_size *= 2;
+    }
+    buffer->index = (unsigned int*) calloc(index_size, sizeof(unsigned int));
+    buffer->index_mask = index_size - 1;
+
+    if (pthread_mutex_init(&buffer->mutex, NULL) != 0) {
+        perror("Mutex initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_cond_init(&buffer->is_not_full, NULL) != 0 || pthread_cond_init(&buffer->is_not_empty, NULL) != 0) {
+        perror("Condition variables initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    return buffer;
+}
+
+// Dealloca tutte le risorse del buffer
+void conflating_buffer_destroy(conflating_buffer_t* buffer) {
+    // Distrugge i messaggi rimanenti usando il loro distruttore specifico
+    while (buffer->current_size > 0) {
+        msg_t* msg_to_destroy = buffer->messages[buffer->head];
+        buffer->head = (buffer->head + 1) % buffer->max_size;
+        buffer->current_size--;
+        msg_to_destroy->msg_destroy(msg_to_destroy);
+    }
+
+    free(buffer->messages);
+    free(buffer->keys);
+    free(buffer->index);
+    pthread_mutex_destroy(&buffer->mutex);
+    pthread_cond_destroy(&buffer->is_not_full);
+    pthread_cond_destroy(&buffer->is_not_empty);
+    free(buffer);
+}
+
+// Inserisce o sostituisce un messaggio, bloccante solo se la chiave è nuova ed il buffer è pieno
+msg_t* put_conflating_bloccante(conflating_buffer_t* buffer, unsigned long key, msg_t* msg) {
+    if (msg != NULL) {
+        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+        // Attende spazio solo se la chiave non ha già un messaggio in attesa
+        unsigned int b = cerca_bucket(buffer, key);
+        while (buffer->index[b] == 0 && buffer->current_size >= buffer->max_size) {
+            pthread_cond_wait(&buffer->is_not_full, &buffer->mutex);
+            b = cerca_bucket(buffer, key);
+        }
+
+        msg_t* old = inserisci(buffer, b, key, msg);
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+        if (old != NULL) {
+            old->msg_destroy(old);
+        }
+    }
+
+    return msg;
+}
+
+// Inserisce o sostituisce un messaggio, non bloccante (fallisce se la chiave è nuova ed il buffer è pieno)
+msg_t* put_conflating_non_bloccante(conflating_buffer_t* buffer, unsigned long key, msg_t* msg) {
+    if (msg != NULL) {
+        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+        unsigned int b = cerca_bucket(buffer, key);
+        if (buffer->index[b] == 0 && buffer->current_size >= buffer->max_size) {
+            pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+            return BUFFER_ERROR;
+        }
+
+        msg_t* old = inserisci(buffer, b, key, msg);
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+        if (old != NULL) {
+            old->msg_destroy(old);
+        }
+    }
+
+    return msg;
+}
+
+// Estrae il messaggio più vecchio, bloccante se il buffer è vuoto
+msg_t* get_conflating_bloccante(conflating_buffer_t* buffer) {
+    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+    // Attende finché il buffer non è più vuoto
+    while (buffer->current_size <= 0) {
+        pthread_cond_wait(&buffer->is_not_empty, &buffer->mutex);
+    }
+    msg_t* msg = estrai(buffer);
+
+    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Estrae il messaggio più vecchio, non bloccante (fallisce se il buffer è vuoto)
+msg_t* get_conflating_non_bloccante(conflating_buffer_t* buffer) {
+    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+    if (buffer->current_size <= 0) { // Se è vuoto
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+        return BUFFER_ERROR;
+    }
+    msg_t* msg = estrai(buffer);
+
+    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Restituisce il numero di messaggi sostituiti
+unsigned long conflating_buffer_conflated(conflating_buffer_t* buffer) {
+    pthread_mutex_lock(&buffer->mutex);
+    unsigned long conflated = buffer->conflated;
+    pthread_mutex_unlock(&buffer->mutex);
+
+    return conflated;
+}
@@ -0,0 +1,54 @@
+#ifndef CONFLATING_BUFFER_H
+#define CONFLATING_BUFFER_H
+
+#include <pthread.h>
+#include "buffer.h"
+#include "message.h"
+
+// buffer FIFO in cui ogni chiave ha al più un messaggio in attesa:
+// un nuovo messaggio per una chiave già presente sostituisce il
+// precedente mantenendone la posizione in coda
+typedef struct conflating_buffer {
+    msg_t** messages;        // coda circolare dei messaggi in attesa
+    unsigned long* keys;     // chiave di ogni posizione della coda
+    unsigned int max_size;
+    unsigned int head;
+    unsigned int current_size;
+    unsigned int* index;     // tabella hash chiave -> posizione + 1 (0 = libero)
+    unsigned int index_mask;
+    unsigned long conflated; // messaggi sostituiti prima di essere estratti
+    pthread_mutex_t mutex;
+    pthread_cond_t is_not_full;
+    pthread_cond_t is_not_empty;
+} conflating_buffer_t;
+
+/* allocazione / deallocazione buffer */
+
+// creazione di un buffer vuoto di dim. max nota
+conflating_buffer_t* conflating_buffer_init(unsigned int max_size);
+
+// deallocazione di un buffer
+void conflating_buffer_destroy(conflating_buffer_t* buffer);
+
+/* operazioni sul buffer */
+
+// inserimento bloccante: se la chiave ha già un messaggio in attesa lo
+// sostituisce sul posto (distruggendolo con il suo msg_destroy) senza
+// mai sospendere; altrimenti sospende se pieno e accoda in fondo
+// restituisce il messaggio inserito; N.B.: msg!=null
+msg_t* put_conflating_bloccante(conflating_buffer_t* buffer, unsigned long key, msg_t* msg);
+
+// inserimento non bloccante: come sopra, ma restituisce BUFFER_ERROR
+// se la chiave non è presente ed il buffer è pieno; N.B.: msg!=null
+msg_t* put_conflating_non_bloccante(conflating_buffer_t* buffer, unsigned long key, msg_t* msg);
+
+// estrazione bloccante del messaggio più vecchio: sospende se vuoto
+msg_t* get_conflating_bloccante(conflating_buffer_t* buffer);
+
+// estrazione non bloccante: restituisce BUFFER_ERROR se vuoto
+msg_t* get_conflating_non_bloccante(conflating_buffer_t* buffer);
+
+// numero di messaggi sostituiti da uno più recente prima dell'estrazione
+unsigned long conflating_buffer_conflated(conflating_buffer_t* buffer);
+
+#endif // CONFLATING_BUFFER_H
@@ -0,0 +1,805 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "durable_queue.h"
+
+// Un record ogni DURABLE_INDEX_INTERVAL finisce nell'indice del suo segmento
+#define DURABLE_INDEX_INTERVAL 64
+
+// I record sono allineati a 8 byte
+#define DURABLE_RECORD_ALIGN(n) (((n) + 7) & ~(size_t) 7)
+
+// File di un segmento: sequenza del suo primo record su 20 cifre, più estensione
+#define DURABLE_SEGMENT_DIGITS 20
+#define DURABLE_LOG_EXT ".log"
+#define DURABLE_INDEX_EXT ".idx"
+
+// Intestazione di un record del log, seguita da length byte di contenuto serializzato
+typedef struct durable_record {
+    uint64_t seq;
+    uint32_t length;
+    uint32_t checksum;
+} durable_record_t;
+
+// Voce dell'indice sparso: il record seq inizia all'offset offset del segmento
+typedef struct durable_index_entry {
+    uint64_t seq;
+    uint64_t offset;
+} durable_index_entry_t;
+
+// Posto del checkpoint: ack_floor durevole, con checksum contro scritture interrotte
+typedef struct durable_checkpoint {
+    uint64_t floor;
+    uint32_t checksum;
+    uint32_t unused;
+} durable_checkpoint_t;
+
+// Segmento mappato durante il ripristino
+typedef struct durable_mapping {
+    char* data;
+    size_t size;
+    size_t start;            // primo record da rileggere
+    size_t end;              // fine dei record integri
+} durable_mapping_t;
+
+// Checksum FNV-1a di intestazione e contenuto: riconosce i record troncati da un crash
+static uint32_t checksum(uint64_t seq, uint32_t length, const char* data) {
+    uint32_t hash = 2166136261u;
+    const unsigned char* bytes = (const unsigned char*) &seq;
+
+    for (size_t i = 0; i < sizeof(seq); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    bytes = (const unsigned char*) &length;
+    for (size_t i = 0; i < sizeof(length); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+// Scrive tutto il contenuto, riprovando dopo scritture parziali
+static void scrivi_tutto(int fd, const void* data, size_t length) {
+    const char* cursor = (const char*) data;
+
+    while (length > 0) {
+        ssize_t written = write(fd, cursor, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Durable queue write failed!");
+            exit(EXIT_FAILURE);
+        }
+        cursor += written;
+        length -= (size_t) written;
+    }
+}
+
+// Legge un intero file in memoria; restituisce NULL se vuoto
+static char* leggi_file(int fd, size_t* length) {
+    struct stat st;
+    fstat(fd, &st);
+    *length = (size_t) st.st_size;
+
+    if (*length == 0) {
+        return NULL;
+    }
+
+    char* data = (char*) malloc(*length);
+    if (pread(fd, data, *length, 0) != (ssize_t) *length) {
+        perror("Durable queue read failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    return data;
+}
+
+// Apre uno dei file della coda nella directory
+static int apri_file(const char* directory, const char* name, int flags) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+    int fd = open(path, O_RDWR | O_CREAT | flags, 0600);
+    if (fd < 0) {
+        perror("Durable queue file open failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    return fd;
+}
+
+// Nome di un file del segmento che inizia con la sequenza base
+static void nome_segmento(char* name, size_t size, uint64_t base, const char* ext) {
+    snprintf(name, size, "%0*" PRIu64 "%s", DURABLE_SEGMENT_DIGITS, base, ext);
+}
+
+// Rende durevoli creazioni, rimozioni e rinomine nella directory
+static void sincronizza_directory(durable_queue_t* queue) {
+    if (fsync(queue->dir_fd) != 0) {
+        perror("Durable queue directory sync failed!");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Aggiunge un segmento in coda all'elenco
+static void aggiungi_segmento(durable_queue_t* queue, uint64_t base) {
+    if (queue->num_segments == queue->segments_capacity) {
+        queue->segments_capacity = queue->segments_capacity > 0 ? queue->segments_capacity * 2 : 16;
+        queue->segments = (uint64_t*) realloc(queue->segments, sizeof(uint64_t) * queue->segments_capacity);
+    }
+    queue->segments[queue->num_segments++] = base;
+}
+
+// Crea il segmento base e ne fa il segmento corrente (solo thread di commit)
+static void apri_segmento(durable_queue_t* queue, uint64_t base) {
+    char name[64];
+
+    if (queue->log_fd >= 0) {
+        close(queue->log_fd);
+        close(queue->index_fd);
+    }
+
+    nome_segmento(name, sizeof(name), base, DURABLE_LOG_EXT);
+    queue->log_fd = apri_file(queue->directory, name, O_APPEND);
+    nome_segmento(name, sizeof(name), base, DURABLE_INDEX_EXT);
+    queue->index_fd = apri_file(queue->directory, name, O_APPEND);
+    sincronizza_directory(queue); // Un record durevole non deve sparire con il suo file
+
+    queue->segment_base = base;
+    aggiungi_segmento(queue, base);
+}
+
+// Rimuove i file di un segmento: prima l'indice, così non sopravvive al suo log
+static void rimuovi_segmento(durable_queue_t* queue, uint64_t base) {
+    char name[64];
+    char path[4096];
+
+    nome_segmento(name, sizeof(name), base, DURABLE_INDEX_EXT);
+    snprintf(path, sizeof(path), "%s/%s", queue->directory, name);
+    unlink(path);
+    nome_segmento(name, sizeof(name), base, DURABLE_LOG_EXT);
+    snprintf(path, sizeof(path), "%s/%s", queue->directory, name);
+    unlink(path);
+}
+
+// Rimuove i segmenti con tutti i record sotto floor; con all anche il
+// segmento corrente, se floor è la prossima sequenza (solo thread di commit)
+static void recupera_segmenti(durable_queue_t* queue, uint64_t floor, bool all) {
+    unsigned int removed = 0;
+
+    // Un segmento contiene le sequenze fino all'inizio del successivo
+    while (removed < queue->num_segments &&
+           (removed + 1 < queue->num_segments ? queue->segments[removed + 1] <= floor : all)) {
+        if (queue->segments[removed] == queue->segment_base && queue->log_fd >= 0) {
+            close(queue->log_fd);
+            close(queue->index_fd);
+            queue->log_fd = -1;
+            queue->index_fd = -1;
+        }
+        rimuovi_segmento(queue, queue->segments[removed]);
+        removed++;
+    }
+
+    if (removed > 0) {
+        sincronizza_directory(queue);
+        queue->num_segments -= removed;
+        memmove(queue->segments, queue->segments + removed, sizeof(uint64_t) * queue->num_segments);
+        queue->reclaimed += removed;
+    }
+}
+
+// Rende durevole ack_floor nel posto del checkpoint non usato dall'ultima scrittura
+static void scrivi_checkpoint(durable_queue_t* queue, uint64_t floor) {
+    durable_checkpoint_t checkpoint = { floor, checksum(floor, 0, NULL), 0 };
+    off_t position = (off_t) (queue->checkpoints++ % 2) * (off_t) sizeof(checkpoint);
+
+    if (pwrite(queue->checkpoint_fd, &checkpoint, sizeof(checkpoint), position) != (ssize_t) sizeof(checkpoint)) {
+        perror("Durable queue checkpoint write failed!");
+        exit(EXIT_FAILURE);
+    }
+    fdatasync(queue->checkpoint_fd);
+}
+
+// Sostituisce il file delle conferme con le sole conferme oltre il floor
+// del checkpoint: una rinomina atomica, mai un file a metà
+static void compatta_conferme(durable_queue_t* queue, const uint64_t* acks, unsigned int count) {
+    int fd = apri_file(queue->directory, "queue.ack.tmp", O_TRUNC);
+    scrivi_tutto(fd, acks, sizeof(uint64_t) * count);
+    fdatasync(fd);
+
+    char from[4096], to[4096];
+    snprintf(from, sizeof(from), "%s/queue.ack.tmp", queue->directory);
+    snprintf(to, sizeof(to), "%s/queue.ack", queue->directory);
+    if (rename(from, to) != 0) {
+        perror("Durable queue ack compaction failed!");
+        exit(EXIT_FAILURE);
+    }
+    sincronizza_directory(queue);
+    close(fd);
+
+    close(queue->ack_fd);
+    queue->ack_fd = apri_file(queue->directory, "queue.ack", O_APPEND);
+    queue->ack_entries = count;
+}
+
+// Ordina le sequenze iniziali dei segmenti
+static int confronta_segmenti(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+// Elenca i segmenti presenti nella directory, in ordine di sequenza
+static void elenca_segmenti(durable_queue_t* queue) {
+    DIR* dir = opendir(queue->directory);
+    if (dir == NULL) {
+        perror("Durable queue directory open failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char* end;
+        uint64_t base = strtoull(entry->d_name, &end, 10);
+        if (end == entry->d_name + DURABLE_SEGMENT_DIGITS && strcmp(end, DURABLE_LOG_EXT) == 0) {
+            aggiungi_segmento(queue, base);
+        }
+    }
+    closedir(dir);
+
+    if (queue->num_segments > 1) {
+        qsort(queue->segments, queue->num_segments, sizeof(uint64_t), confronta_segmenti);
+    }
+}
+
+// Offset da cui rileggere il segmento per arrivare a floor: la voce
+// dell'indice più vicina, purché punti ad un record integro con la sequenza attesa
+static size_t offset_indicizzato(durable_queue_t* queue, uint64_t base, uint64_t floor, const char* log, size_t log_size) {
+    char name[64];
+    size_t length;
+    size_t offset = 0;
+    uint64_t index_seq = 0;
+
+    nome_segmento(name, sizeof(name), base, DURABLE_INDEX_EXT);
+    int fd = apri_file(queue->directory, name, O_APPEND);
+    durable_index_entry_t* index = (durable_index_entry_t*) leggi_file(fd, &length);
+    close(fd);
+
+    size_t num_entries = length / sizeof(durable_index_entry_t);
+    for (size_t i = 0; i < num_entries; i++) {
+        if (index[i].seq <= floor && index[i].offset > offset) {
+            offset = (size_t) index[i].offset;
+            index_seq = index[i].seq;
+        }
+    }
+    free(index);
+
+    if (offset > 0) {
+        durable_record_t* record = (durable_record_t*) (log + offset);
+        if (offset + sizeof(durable_record_t) > log_size || record->seq != index_seq ||
+            offset + sizeof(durable_record_t) + DURABLE_RECORD_ALIGN(record->length) > log_size ||
+            record->checksum != checksum(record->seq, record->length, log + offset + sizeof(durable_record_t))) {
+            offset = 0;
+        }
+    }
+
+    return offset;
+}
+
+// Avanza ack_floor oltre i messaggi confermati (mutex acquisito)
+static void avanza_floor(durable_queue_t* queue) {
+    bool advanced = false;
+
+    while (queue->ack_floor < queue->next_seq && queue->slots[queue->ack_floor % queue->max_size].acked) {
+        queue->slots[queue->ack_floor % queue->max_size].acked = false;
+        queue->ack_floor++;
+        advanced = true;
+    }
+
+    if (advanced) {
+        pthread_cond_broadcast(&queue->is_not_full); // Segnala che non è più piena
+    }
+}
+
+// Ripristina lo stato da checkpoint, conferme e segmenti di una esecuzione precedente
+static void ripristina(durable_queue_t* queue, unsigned int max_size) {
+    size_t length;
+    uint64_t floor = 0;
+
+    // Checkpoint: il più alto dei due posti integri
+    durable_checkpoint_t checkpoints[2];
+    memset(checkpoints, 0, sizeof(checkpoints));
+    if (pread(queue->checkpoint_fd, checkpoints, sizeof(checkpoints), 0) < 0) {
+        perror("Durable queue read failed!");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned int i = 0; i < 2; i++) {
+        if (checkpoints[i].checksum == checksum(checkpoints[i].floor, 0, NULL) && checkpoints[i].floor >= floor) {
+            floor = checkpoints[i].floor;
+            queue->checkpoints = i + 1; // Il prossimo checkpoint usa l'altro posto
+        }
+    }
+
+    // Conferme oltre il floor; una compattazione interrotta non ha effetto
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s/queue.ack.tmp", queue->directory);
+    unlink(tmp);
+    uint64_t* acks = (uint64_t*) leggi_file(queue->ack_fd, &length);
+    size_t num_acks = length / sizeof(uint64_t);
+    queue->ack_entries = num_acks;
+
+    // Segmenti: quelli completamente confermati non servono più
+    elenca_segmenti(queue);
+    recupera_segmenti(queue, floor, false);
+
+    // Primo passaggio per validare i record e trovare la fine del log
+    durable_mapping_t* mappings = (durable_mapping_t*) calloc(queue->num_segments + 1, sizeof(durable_mapping_t));
+    unsigned int valid_segments = 0;
+    uint64_t next_seq = floor;
+    bool first_record = true;
+
+    for (unsigned int s = 0; s < queue->num_segments; s++) {
+        char name[64];
+        nome_segmento(name, sizeof(name), queue->segments[s], DURABLE_LOG_EXT);
+        int fd = apri_file(queue->directory, name, O_APPEND);
+
+        struct stat st;
+        fstat(fd, &st);
+        durable_mapping_t* mapping = &mappings[s];
+        mapping->size = (size_t) st.st_size;
+        mapping->data = mapping->size > 0 ? (char*) mmap(NULL, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+        mapping->start = s == 0 && mapping->size > 0 ? offset_indicizzato(queue, queue->segments[s], floor, mapping->data, mapping->size) : 0;
+
+        size_t offset = mapping->start;
+        bool broken = false;
+        while (offset + sizeof(durable_record_t) <= mapping->size) {
+            durable_record_t* record = (durable_record_t*) (mapping->data + offset);
+            size_t end = offset + sizeof(durable_record_t) + DURABLE_RECORD_ALIGN(record->length);
+            if (end > mapping->size ||
+                record->checksum != checksum(record->seq, record->length, mapping->data + offset + sizeof(durable_record_t)) ||
+                (!first_record && record->seq != next_seq)) {
+                broken = true;
+                break;
+            }
+            first_record = false;
+            next_seq = record->seq + 1;
+            offset = end;
+        }
+        mapping->end = offset;
+        broken = broken || offset < mapping->size;
+
+        // Un record incompleto in coda al log è stato interrotto da un crash
+        if (broken) {
+            ftruncate(fd, (off_t) offset);
+            fdatasync(fd);
+        }
+        close(fd);
+        valid_segments = s + 1;
+
+        if (broken) {
+            break;
+        }
+    }
+
+    // I segmenti successivi ad un record interrotto non possono essere integri
+    for (unsigned int s = valid_segments; s < queue->num_segments; s++) {
+        rimuovi_segmento(queue, queue->segments[s]);
+    }
+    if (valid_segments < queue->num_segments) {
+        sincronizza_directory(queue);
+        queue->num_segments = valid_segments;
+    }
+
+    if (next_seq < floor) {
+        next_seq = floor;
+    }
+
+    // L'ultimo segmento resta il segmento corrente
+    queue->log_fd = -1;
+    queue->index_fd = -1;
+    queue->log_end = 0;
+    if (queue->num_segments > 0) {
+        char name[64];
+        queue->segment_base = queue->segments[queue->num_segments - 1];
+        nome_segmento(name, sizeof(name), queue->segment_base, DURABLE_LOG_EXT);
+        queue->log_fd = apri_file(queue->directory, name, O_APPEND);
+        nome_segmento(name, sizeof(name), queue->segment_base, DURABLE_INDEX_EXT);
+        queue->index_fd = apri_file(queue->directory, name, O_APPEND);
+        queue->log_end = (off_t) mappings[queue->num_segments - 1].end;
+    }
+
+    // Una esecuzione precedente con una finestra più ampia impone la sua
+    queue->max_size = next_seq - floor > max_size ? (unsigned int) (next_seq - floor) : max_size;
+    queue->slots = (durable_slot_t*) calloc(queue->max_size, sizeof(durable_slot_t));
+    queue->next_seq = next_seq;
+    queue->durable_seq = next_seq;
+    queue->deliver_seq = floor;
+    queue->ack_floor = floor;
+    queue->written_floor = floor;
+
+    for (size_t i = 0; i < num_acks; i++) {
+        if (acks[i] >= floor && acks[i] < next_seq) {
+            queue->slots[acks[i] % queue->max_size].acked = true;
+        }
+    }
+    free(acks);
+
+    // Secondo passaggio: ricrea i messaggi non confermati, direttamente dalla mappatura
+    for (unsigned int s = 0; s < valid_segments; s++) {
+        durable_mapping_t* mapping = &mappings[s];
+
+        for (size_t offset = mapping->start; offset < mapping->end;) {
+            durable_record_t* record = (durable_record_t*) (mapping->data + offset);
+            char* data = mapping->data + offset + sizeof(durable_record_t);
+            durable_slot_t* slot = &queue->slots[record->seq % queue->max_size];
+
+            if (record->seq >= floor && !slot->acked) {
+                slot->msg = queue->codec->read(data, record->length);
+                queue->recovered++;
+            }
+            offset += sizeof(durable_record_t) + DURABLE_RECORD_ALIGN(record->length);
+        }
+    }
+
+    for (unsigned int s = 0; s < valid_segments; s++) {
+        if (mappings[s].data != NULL) {
+            munmap(mappings[s].data, mappings[s].size);
+        }
+    }
+    free(mappings);
+
+    avanza_floor(queue);
+}
+
+// Thread di commit: scrive i record accumulati e li rende durevoli con un solo fsync
+static void* committer_loop(void* arg) {
+    durable_queue_t* queue = (durable_queue_t*) arg;
+    char* batch = NULL;
+    size_t batch_capacity = 0;
+    uint64_t* acks = NULL;
+    unsigned int acks_capacity = 0;
+
+    pthread_mutex_lock(&queue->mutex);
+    for (;;) {
+        // Le sole conferme non giustificano un fsync finché non sono batch_size
+        while (queue->pending_length == 0 && queue->pending_acks_count < queue->batch_size && !queue->closing) {
+            pthread_cond_wait(&queue->has_pending, &queue->mutex);
+        }
+        if (queue->pending_length == 0 && queue->pending_acks_count == 0 && queue->ack_floor == queue->written_floor) {
+            break; // In chiusura e senza nulla da scrivere
+        }
+
+        // Raccoglie altri record finché il gruppo non è pieno o la finestra non scade
+        if (queue->pending_length > 0) {
+            struct timespec deadline = queue->pending_since;
+            deadline.tv_nsec += queue->window_ns;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+
+            while (queue->next_seq - queue->durable_seq < queue->batch_size && !queue->closing &&
+                   pthread_cond_timedwait(&queue->has_pending, &queue->mutex, &deadline) != ETIMEDOUT) {
+            }
+        }
+
+        // Prende il gruppo: i produttori continuano a riempire il buffer scambiato
+        char* records = queue->pending;
+        size_t records_length = queue->pending_length;
+        size_t records_capacity = queue->pending_capacity;
+        queue->pending = batch;
+        queue->pending_capacity = batch_capacity;
+        queue->pending_length = 0;
+        batch = records;
+        batch_capacity = records_capacity;
+
+        uint64_t* batch_acks = queue->pending_acks;
+        unsigned int batch_acks_count = queue->pending_acks_count;
+        unsigned int batch_acks_capacity = queue->pending_acks_capacity;
+        queue->pending_acks = acks;
+        queue->pending_acks_capacity = acks_capacity;
+        queue->pending_acks_count = 0;
+        acks = batch_acks;
+        acks_capacity = batch_acks_capacity;
+
+        uint64_t batch_end = queue->next_seq;
+        uint64_t floor = queue->ack_floor;
+        off_t log_end = queue->log_end;
+
+        // Troppe conferme sul disco: resteranno solo quelle oltre il floor
+        uint64_t* live_acks = NULL;
+        unsigned int live_count = 0;
+        if (queue->ack_entries + batch_acks_count > 2 * (unsigned long) queue->max_size) {
+            live_acks = (uint64_t*) malloc(sizeof(uint64_t) * (queue->next_seq - floor + 1));
+            for (uint64_t seq = floor; seq < queue->next_seq; seq++) {
+                if (queue->slots[seq % queue->max_size].acked) {
+                    live_acks[live_count++] = seq;
+                }
+            }
+        }
+        pthread_mutex_unlock(&queue->mutex);
+
+        if (records_length > 0) {
+            // Segmento corrente pieno: il gruppo inizia un nuovo segmento
+            if (queue->log_fd < 0 || log_end >= (off_t) queue->segment_size) {
+                apri_segmento(queue, ((durable_record_t*) records)->seq);
+                log_end = 0;
+            }
+
+            scrivi_tutto(queue->log_fd, records, records_length);
+            fdatasync(queue->log_fd);
+
+            // L'indice si aggiorna solo dopo che i record indicizzati sono durevoli
+            for (size_t offset = 0; offset < records_length;) {
+                durable_record_t* record = (durable_record_t*) (records + offset);
+                if (record->seq % DURABLE_INDEX_INTERVAL == 0) {
+                    durable_index_entry_t entry = { record->seq, (uint64_t) log_end + offset };
+                    scrivi_tutto(queue->index_fd, &entry, sizeof(entry));
+                }
+                offset += sizeof(durable_record_t) + DURABLE_RECORD_ALIGN(record->length);
+            }
+        }
+
+        if (batch_acks_count > 0) {
+            scrivi_tutto(queue->ack_fd, batch_acks, sizeof(uint64_t) * batch_acks_count);
+            fdatasync(queue->ack_fd);
+            queue->ack_entries += batch_acks_count;
+        }
+
+        // Il floor sostituisce le conferme precedenti: i segmenti sotto di esso si possono rimuovere
+        if (floor > queue->written_floor) {
+            scrivi_checkpoint(queue, floor);
+            recupera_segmenti(queue, floor, false);
+        }
+        if (live_acks != NULL) {
+            compatta_conferme(queue, live_acks, live_count);
+            free(live_acks);
+        }
+
+        pthread_mutex_lock(&queue->mutex);
+        queue->log_end = log_end + (off_t) records_length;
+        queue->durable_seq = batch_end;
+        queue->written_floor = floor;
+        if (records_length > 0) {
+            queue->commits++;
+            pthread_cond_broadcast(&queue->is_durable);   // Sblocca i produttori del gruppo
+            pthread_cond_broadcast(&queue->is_not_empty); // Segnala che non è più vuota
+        }
+    }
+    pthread_mutex_unlock(&queue->mutex);
+
+    free(batch);
+    free(acks);
+    return NULL;
+}
+
+// Apre la coda persistente ripristinando i messaggi non confermati
+durable_queue_t* durable_queue_open(const char* directory, unsigned int max_size, size_t segment_size,
+                                    unsigned int batch_size, unsigned int window_us, const spill_codec_t* codec) {
+    durable_queue_t* queue = (durable_queue_t*) malloc(sizeof(durable_queue_t));
+    queue->codec = codec;
+    queue->directory = strdup(directory);
+    queue->dir_fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (queue->dir_fd < 0) {
+        perror("Durable queue directory open failed!");
+        exit(EXIT_FAILURE);
+    }
+    queue->ack_fd = apri_file(directory, "queue.ack", O_APPEND);
+    queue->checkpoint_fd = apri_file(directory, "queue.ckpt", 0);
+    queue->segment_size = segment_size;
+    queue->segments = NULL;
+    queue->num_segments = 0;
+    queue->segments_capacity = 0;
+    queue->segment_base = 0;
+    queue->log_fd = -1;
+    queue->index_fd = -1;
+    queue->checkpoints = 0;
+    queue->reclaimed = 0;
+    queue->batch_size = batch_size > 0 ? batch_size : 1;
+    queue->window_ns = (long) window_us * 1000L;
+    queue->pending = NULL;
+    queue->pending_length = 0;
+    queue->pending_capacity = 0;
+    queue->pending_acks = NULL;
+    queue->pending_acks_count = 0;
+    queue->pending_acks_capacity = 0;
+    queue->commits = 0;
+    queue->recovered = 0;
+    queue->closing = false;
+
+    pthread_condattr_t monotonic;
+    pthread_condattr_init(&monotonic);
+    pthread_condattr_setclock(&monotonic, CLOCK_MONOTONIC);
+
+    if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
+        perror("Mutex initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_cond_init(&queue->has_pending, &monotonic) != 0 || pthread_cond_init(&queue->is_durable, NULL) != 0 ||
+        pthread_cond_init(&queue->is_not_empty, NULL) != 0 || pthread_cond_init(&queue->is_not_full, NULL) != 0) {
+        perror("Condition variables initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+    pthread_condattr_destroy(&monotonic);
+
+    ripristina(queue, max_size);
+
+    if (pthread_create(&queue->committer, NULL, committer_loop, queue) != 0) {
+        perror("Committer creation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    return queue;
+}
+
+// Chiude la coda dopo aver reso durevole tutto ciò che è in attesa
+void durable_queue_close(durable_queue_t* queue) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->closing = true;
+    pthread_cond_signal(&queue->has_pending);
+    pthread_mutex_unlock(&queue->mutex);
+    pthread_join(queue->committer, NULL);
+
+    // Tutto confermato: la coda riparte vuota, dalla sequenza 0; prima i
+    // segmenti, poi le conferme ed infine il checkpoint, così dopo un crash
+    // il floor durevole copre sempre le conferme ed i segmenti rimasti
+    if (queue->ack_floor == queue->next_seq) {
+        recupera_segmenti(queue, queue->ack_floor, true);
+        ftruncate(queue->ack_fd, 0);
+        fdatasync(queue->ack_fd);
+        ftruncate(queue->checkpoint_fd, 0);
+        fdatasync(queue->checkpoint_fd);
+    }
+
+    // Distrugge i messaggi non consegnati usando il loro distruttore specifico
+    for (uint64_t seq = queue->deliver_seq; seq < queue->next_seq; seq++) {
+        msg_t* msg_to_destroy = queue->slots[seq % queue->max_size].msg;
+        if (msg_to_destroy != NULL) {
+            msg_to_destroy->msg_destroy(msg_to_destroy);
+        }
+    }
+
+    if (queue->log_fd >= 0) {
+        close(queue->log_fd);
+        close(queue->index_fd);
+    }
+    close(queue->ack_fd);
+    close(queue->checkpoint_fd);
+    close(queue->dir_fd);
+    free(queue->directory);
+    free(queue->segments);
+    free(queue->slots);
+    free(queue->pending);
+    free(queue->pending_acks);
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->has_pending);
+    pthread_cond_destroy(&queue->is_durable);
+    pthread_cond_destroy(&queue->is_not_empty);
+    pthread_cond_destroy(&queue->is_not_full);
+    free(queue);
+}
+
+// Inserisce un messaggio e attende che sia durevole
+msg_t* put_durable_bloccante(durable_queue_t* queue, msg_t* msg) {
+    if (msg != NULL) {
+        pthread_mutex_lock(&queue->mutex); // Blocca l'accesso
+
+        // Attende finché la finestra dei messaggi non confermati non è più piena
+        while (queue->next_seq - queue->ack_floor >= queue->max_size) {
+            pthread_cond_wait(&queue->is_not_full, &queue->mutex);
+        }
+
+        uint64_t seq = queue->next_seq++;
+        queue->slots[seq % queue->max_size].msg = msg;
+        queue->slots[seq % queue->max_size].acked = false;
+
+        // Serializza in coda al gruppo in attesa di commit
+        uint32_t length = (uint32_t) queue->codec->size(msg);
+        size_t needed = queue->pending_length + sizeof(durable_record_t) + DURABLE_RECORD_ALIGN(length);
+        if (needed > queue->pending_capacity) {
+            queue->pending_capacity = needed * 2;
+            queue->pending = (char*) realloc(queue->pending, queue->pending_capacity);
+        }
+
+        char* out = queue->pending + queue->pending_length;
+        char* data = out + sizeof(durable_record_t);
+        queue->codec->write(msg, data);
+        memset(data + length, 0, DURABLE_RECORD_ALIGN(length) - length);
+        durable_record_t record = { seq, length, checksum(seq, length, data) };
+        memcpy(out, &record, sizeof(record));
+
+        if (queue->pending_length == 0) {
+            clock_gettime(CLOCK_MONOTONIC, &queue->pending_since);
+        }
+        queue->pending_length = needed;
+        pthread_cond_signal(&queue->has_pending);
+
+        // Attende il commit del gruppo che contiene il messaggio
+        while (queue->durable_seq <= seq) {
+            pthread_cond_wait(&queue->is_durable, &queue->mutex);
+        }
+
+        pthread_mutex_unlock(&queue->mutex); // Sblocca l'accesso
+    }
+
+    return msg;
+}
+
+// Consegna il prossimo messaggio durevole (mutex acquisito); BUFFER_ERROR se non ce ne sono
+static msg_t* estrai(durable_queue_t* queue, uint64_t* seq) {
+    // I messaggi già confermati prima di un riavvio non vengono riconsegnati
+    while (queue->deliver_seq < queue->durable_seq && queue->slots[queue->deliver_seq % queue->max_size].msg == NULL) {
+        queue->deliver_seq++;
+    }
+
+    if (queue->deliver_seq >= queue->durable_seq) {
+        return BUFFER_ERROR;
+    }
+
+    durable_slot_t* slot = &queue->slots[queue->deliver_seq % queue->max_size];
+    msg_t* msg = slot->msg;
+    slot->msg = NULL;
+    *seq = queue->deliver_seq++;
+
+    return msg;
+}
+
+// Estrae un messaggio, bloccante se non ce ne sono di durevoli
+msg_t* get_durable_bloccante(durable_queue_t* queue, uint64_t* seq) {
+    msg_t* msg;
+
+    pthread_mutex_lock(&queue->mutex); // Blocca l'accesso
+
+    // Attende finché non c'è un messaggio durevole da consegnare
+    while ((msg = estrai(queue, seq)) == BUFFER_ERROR) {
+        pthread_cond_wait(&queue->is_not_empty, &queue->mutex);
+    }
+
+    pthread_mutex_unlock(&queue->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Estrae un messaggio, non bloccante (fallisce se non ce ne sono di durevoli)
+msg_t* get_durable_non_bloccante(durable_queue_t* queue, uint64_t* seq) {
+    pthread_mutex_lock(&queue->mutex); // Blocca l'accesso
+    msg_t* msg = estrai(queue, seq);
+    pthread_mutex_unlock(&queue->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Conferma l'elaborazione di un messaggio consegnato
+void durable_queue_ack(durable_queue_t* queue, uint64_t seq) {
+    pthread_mutex_lock(&queue->mutex);
+
+    if (seq >= queue->ack_floor && seq < queue->deliver_seq && !queue->slots[seq % queue->max_size].acked) {
+        queue->slots[seq % queue->max_size].acked = true;
+
+        if (queue->pending_acks_count == queue->pending_acks_capacity) {
+            queue->pending_acks_capacity = queue->pending_acks_capacity > 0 ? queue->pending_acks_capacity * 2 : 64;
+            queue->pending_acks = (uint64_t*) realloc(queue->pending_acks, sizeof(uint64_t) * queue->pending_acks_capacity);
+        }
+        queue->pending_acks[queue->pending_acks_count++] = seq;
+
+        avanza_floor(queue);
+        if (queue->pending_acks_count >= queue->batch_size) {
+            pthread_cond_signal(&queue->has_pending);
+        }
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+}
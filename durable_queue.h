@@ -0,0 +1,100 @@
+#ifndef DURABLE_QUEUE_H
+#define DURABLE_QUEUE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "buffer.h"
+#include "message.h"
+#include "spill_buffer.h"
+
+// stato di una posizione della finestra dei messaggi non confermati
+typedef struct durable_slot {
+    msg_t* msg;              // NULL dopo la consegna
+    bool acked;
+} durable_slot_t;
+
+typedef struct durable_queue {
+    const spill_codec_t* codec;
+    char* directory;
+    int dir_fd;              // per rendere durevoli creazione e rimozione dei file
+    int log_fd;              // segmento corrente del log append-only, -1 se nessuno
+    int index_fd;            // indice sparso (sequenza, offset) del segmento corrente
+    int ack_fd;              // conferme dei consumatori oltre il floor del checkpoint
+    int checkpoint_fd;       // ack_floor durevole: due posti a dimensione fissa, alternati
+    size_t segment_size;     // oltre questa dimensione il gruppo successivo apre un nuovo segmento
+    uint64_t segment_base;   // sequenza del primo record del segmento corrente
+    uint64_t* segments;      // sequenza iniziale dei segmenti sul disco, in ordine
+    unsigned int num_segments;
+    unsigned int segments_capacity;
+    unsigned int max_size;   // messaggi accettati e non ancora confermati
+    unsigned int batch_size; // commit al raggiungimento di batch_size record...
+    long window_ns;          // ...oppure window_ns dopo il primo record in attesa
+    durable_slot_t* slots;   // finestra circolare [ack_floor, next_seq)
+    uint64_t next_seq;       // sequenza del prossimo messaggio accettato
+    uint64_t durable_seq;    // i messaggi con sequenza minore sono su disco
+    uint64_t deliver_seq;    // prossimo messaggio da consegnare
+    uint64_t ack_floor;      // i messaggi con sequenza minore sono tutti confermati
+    uint64_t written_floor;  // ultimo ack_floor registrato nel checkpoint
+    off_t log_end;           // dimensione del segmento corrente
+    char* pending;           // record serializzati in attesa del prossimo commit
+    size_t pending_length;
+    size_t pending_capacity;
+    uint64_t* pending_acks;  // conferme in attesa del prossimo commit
+    unsigned int pending_acks_count;
+    unsigned int pending_acks_capacity;
+    struct timespec pending_since;
+    unsigned long ack_entries;   // conferme nel file delle conferme, compattato oltre 2 * max_size
+    unsigned long checkpoints;   // checkpoint scritti: sceglie il posto del prossimo
+    unsigned long commits;
+    unsigned long recovered; // messaggi non confermati ritrovati all'apertura
+    unsigned long reclaimed; // segmenti rimossi perché completamente confermati
+    bool closing;
+    pthread_t committer;
+    pthread_mutex_t mutex;
+    pthread_cond_t has_pending;  // per il thread di commit
+    pthread_cond_t is_durable;   // per i produttori in attesa del commit
+    pthread_cond_t is_not_empty;
+    pthread_cond_t is_not_full;
+} durable_queue_t;
+
+/* apertura / chiusura */
+
+// apertura (o creazione) della coda persistente nella directory
+// directory: i messaggi non confermati di una esecuzione precedente
+// vengono ripristinati e riconsegnati; al più max_size messaggi possono
+// essere accettati e non ancora confermati; il log è diviso in segmenti
+// di circa segment_size byte, rimossi non appena tutti i loro messaggi
+// sono confermati; i record vengono resi durevoli con un unico fsync per
+// gruppo, al raggiungimento di batch_size record o window_us
+// microsecondi dopo il primo in attesa (ogni produttore attende il
+// proprio commit: un batch_size maggiore del numero di produttori
+// concorrenti fa sempre attendere la finestra)
+durable_queue_t* durable_queue_open(const char* directory, unsigned int max_size, size_t segment_size,
+                                    unsigned int batch_size, unsigned int window_us, const spill_codec_t* codec);
+
+// chiusura della coda: rende durevoli record e conferme in attesa e
+// distrugge i messaggi non ancora consegnati (restano sul disco); se
+// tutto è confermato rimuove i segmenti e la sequenza riparte da 0
+void durable_queue_close(durable_queue_t* queue);
+
+/* operazioni sulla coda */
+
+// inserimento bloccante: sospende se la coda è piena, quindi ritorna
+// solo dopo che il messaggio è stato reso durevole; restituisce il
+// messaggio inserito; N.B.: msg!=null
+msg_t* put_durable_bloccante(durable_queue_t* queue, msg_t* msg);
+
+// estrazione bloccante, nell'ordine di inserimento: sospende se non ci
+// sono messaggi durevoli da consegnare; in seq la sequenza da confermare
+msg_t* get_durable_bloccante(durable_queue_t* queue, uint64_t* seq);
+
+// estrazione non bloccante: restituisce BUFFER_ERROR se vuota
+msg_t* get_durable_non_bloccante(durable_queue_t* queue, uint64_t* seq);
+
+// conferma l'elaborazione del messaggio seq: dopo un riavvio non verrà
+// riconsegnato (le conferme diventano durevoli con il commit successivo)
+void durable_queue_ack(durable_queue_t* queue, uint64_t seq);
+
+#endif // DURABLE_QUEUE_H
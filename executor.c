@@ -0,0 +1,351 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "executor.h"
+
+// Worker in esecuzione nel thread corrente (NULL per i thread esterni)
+static __thread executor_worker_t* current_worker = NULL;
+
+// Inizializza una deque vuota di almeno capacity posti
+static void deque_init(executor_deque_t* deque, unsigned int capacity) {
+    unsigned int rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    deque->tasks = (msg_t**) malloc(sizeof(msg_t*) * rounded);
+    deque->capacity = rounded;
+    deque->head = 0;
+    deque->tail = 0;
+
+    if (pthread_mutex_init(&deque->mutex, NULL) != 0) {
+        perror("Mutex initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Inserisce in coda, mutex acquisito; false se piena
+static bool deque_push_locked(executor_deque_t* deque, msg_t* msg) {
+    if (deque->tail - deque->head >= deque->capacity) {
+        return false;
+    }
+
+    deque->tasks[deque->tail & (deque->capacity - 1)] = msg;
+    deque->tail++;
+    return true;
+}
+
+// Inserisce in coda alla propria deque; false se piena
+static bool deque_push(executor_deque_t* deque, msg_t* msg) {
+    pthread_mutex_lock(&deque->mutex);
+    bool pushed = deque_push_locked(deque, msg);
+    pthread_mutex_unlock(&deque->mutex);
+
+    return pushed;
+}
+
+// Estrae dalla coda della propria deque (il task più recente)
+static msg_t* deque_pop(executor_deque_t* deque) {
+    msg_t* msg = NULL;
+
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->tail != deque->head) {
+        deque->tail--;
+        msg = deque->tasks[deque->tail & (deque->capacity - 1)];
+    }
+    pthread_mutex_unlock(&deque->mutex);
+
+    return msg;
+}
+
+// Estrae dalla testa (il task più vecchio), mutex acquisito
+static msg_t* deque_estrai_testa(executor_deque_t* deque) {
+    msg_t* msg = NULL;
+
+    if (deque->tail != deque->head) {
+        msg = deque->tasks[deque->head & (deque->capacity - 1)];
+        deque->head++;
+    }
+
+    return msg;
+}
+
+// Ruba dalla testa della deque di un altro worker (il task più vecchio)
+static msg_t* deque_steal(executor_deque_t* deque) {
+    // Un furto non deve mai far attendere il proprietario
+    if (pthread_mutex_trylock(&deque->mutex) != 0) {
+        return NULL;
+    }
+    msg_t* msg = deque_estrai_testa(deque);
+    pthread_mutex_unlock(&deque->mutex);
+
+    return msg;
+}
+
+// Estrae il task più vecchio della coda di iniezione e libera un posto
+static msg_t* preleva_iniettato(executor_t* executor) {
+    pthread_mutex_lock(&executor->injection.mutex);
+    msg_t* msg = deque_estrai_testa(&executor->injection);
+    if (msg != NULL) {
+        pthread_cond_signal(&executor->injection_not_full); // Segnala che non è più piena
+    }
+    pthread_mutex_unlock(&executor->injection.mutex);
+
+    return msg;
+}
+
+// Annuncia un task prima di renderlo visibile: chi lo prende non può
+// decrementare pending prima dell'incremento
+static void annuncia_lavoro(executor_t* executor) {
+    atomic_fetch_add(&executor->pending, 1);
+}
+
+// Risveglia un worker sospeso dopo che il task annunciato è visibile
+static void notifica_lavoro(executor_t* executor) {
+    if (atomic_load(&executor->parked) > 0) {
+        pthread_mutex_lock(&executor->park_mutex);
+        pthread_cond_signal(&executor->has_work);
+        pthread_mutex_unlock(&executor->park_mutex);
+    }
+}
+
+// Cerca un task: propria deque, coda di iniezione, deque degli altri worker
+static msg_t* cerca_task(executor_worker_t* worker) {
+    executor_t* executor = worker->executor;
+
+    msg_t* msg = deque_pop(&worker->deque);
+    if (msg != NULL) {
+        atomic_fetch_add_explicit(&worker->local, 1, memory_order_relaxed);
+        return msg;
+    }
+
+    msg = preleva_iniettato(executor);
+    if (msg != NULL) {
+        atomic_fetch_add_explicit(&worker->injected, 1, memory_order_relaxed);
+        return msg;
+    }
+
+    for (unsigned int i = 1; i < executor->num_workers; i++) {
+        executor_worker_t* victim = &executor->workers[(worker->id + i) % executor->num_workers];
+        msg = deque_steal(&victim->deque);
+        if (msg != NULL) {
+            atomic_fetch_add_explicit(&worker->stolen, 1, memory_order_relaxed);
+            return msg;
+        }
+    }
+
+    return NULL;
+}
+
+// Sospende il worker finché non arriva lavoro; false se deve terminare
+static bool attendi_lavoro(executor_worker_t* worker) {
+    executor_t* executor = worker->executor;
+    bool has_work;
+
+    pthread_mutex_lock(&executor->park_mutex);
+    atomic_fetch_add(&executor->parked, 1);
+    if (atomic_load(&executor->pending) == 0 && !atomic_load(&executor->shutdown)) {
+        atomic_fetch_add_explicit(&worker->parks, 1, memory_order_relaxed);
+    }
+    while (atomic_load(&executor->pending) == 0 && !atomic_load(&executor->shutdown)) {
+        pthread_cond_wait(&executor->has_work, &executor->park_mutex);
+    }
+    atomic_fetch_sub(&executor->parked, 1);
+    has_work = atomic_load(&executor->pending) > 0;
+    pthread_mutex_unlock(&executor->park_mutex);
+
+    return has_work;
+}
+
+// Ciclo di un worker: esegue task finché il pool non è chiuso e vuoto
+static void* worker_loop(void* arg) {
+    executor_worker_t* worker = (executor_worker_t*) arg;
+    executor_t* executor = worker->executor;
+    current_worker = worker;
+
+    for (;;) {
+        msg_t* msg = cerca_task(worker);
+
+        if (msg != NULL) {
+            atomic_fetch_sub(&executor->pending, 1);
+            executor->task(msg, executor->task_arg);
+            atomic_fetch_add_explicit(&worker->executed, 1, memory_order_relaxed);
+        } else if (atomic_load(&executor->pending) > 0) {
+            // Un task è stato annunciato ma non è ancora visibile
+            sched_yield();
+        } else if (!attendi_lavoro(worker)) {
+            break;
+        }
+    }
+
+    current_worker = NULL;
+    return NULL;
+}
+
+// Crea il pool ed avvia i worker
+executor_t* executor_init(unsigned int num_workers, unsigned int deque_size, unsigned int injection_size,
+                          executor_task_t task, void* task_arg) {
+    executor_t* executor = (executor_t*) malloc(sizeof(executor_t));
+    executor->workers = (executor_worker_t*) malloc(sizeof(executor_worker_t) * num_workers);
+    executor->num_workers = num_workers;
+    deque_init(&executor->injection, injection_size);
+    executor->task = task;
+    executor->task_arg = task_arg;
+    atomic_init(&executor->pending, 0);
+    atomic_init(&executor->parked, 0);
+    atomic_init(&executor->shutdown, false);
+    atomic_init(&executor->submitted, 0);
+    atomic_init(&executor->drained, 0);
+    atomic_init(&executor->joined, false);
+
+    if (pthread_mutex_init(&executor->park_mutex, NULL) != 0 || pthread_cond_init(&executor->has_work, NULL) != 0 ||
+        pthread_cond_init(&executor->injection_not_full, NULL) != 0) {
+        perror("Executor synchronization initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    // Le deque devono esistere tutte prima che un worker provi a rubare
+    for (unsigned int i = 0; i < num_workers; i++) {
+        executor_worker_t* worker = &executor->workers[i];
+        worker->executor = executor;
+        worker->id = i;
+        deque_init(&worker->deque, deque_size);
+        atomic_init(&worker->executed, 0);
+        atomic_init(&worker->local, 0);
+        atomic_init(&worker->injected, 0);
+        atomic_init(&worker->stolen, 0);
+        atomic_init(&worker->parks, 0);
+    }
+
+    for (unsigned int i = 0; i < num_workers; i++) {
+        if (pthread_create(&executor->workers[i].thread, NULL, worker_loop, &executor->workers[i]) != 0) {
+            perror("Worker creation failed!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return executor;
+}
+
+// Sottomette un task al pool
+msg_t* executor_submit(executor_t* executor, msg_t* msg) {
+    if (msg == NULL) {
+        return msg;
+    }
+
+    executor_worker_t* worker = current_worker;
+
+    if (worker != NULL && worker->executor == executor) {
+        // Dall'interno di un worker, anche durante la chiusura: deque locale, poi
+        // coda di iniezione; se entrambe sono piene il task viene eseguito subito
+        atomic_fetch_add_explicit(&executor->submitted, 1, memory_order_relaxed);
+        annuncia_lavoro(executor);
+
+        bool queued = deque_push(&worker->deque, msg);
+        if (!queued) {
+            pthread_mutex_lock(&executor->injection.mutex);
+            queued = deque_push_locked(&executor->injection, msg);
+            pthread_mutex_unlock(&executor->injection.mutex);
+        }
+
+        if (queued) {
+            notifica_lavoro(executor);
+        } else {
+            atomic_fetch_sub(&executor->pending, 1);
+            executor->task(msg, executor->task_arg);
+            atomic_fetch_add_explicit(&worker->executed, 1, memory_order_relaxed);
+        }
+        return msg;
+    }
+
+    // Dall'esterno: controllo della chiusura ed inserimento sono atomici
+    // rispetto ad executor_shutdown, che imposta shutdown con lo stesso mutex
+    pthread_mutex_lock(&executor->injection.mutex);
+    while (!atomic_load(&executor->shutdown) &&
+           executor->injection.tail - executor->injection.head >= executor->injection.capacity) {
+        pthread_cond_wait(&executor->injection_not_full, &executor->injection.mutex);
+    }
+    if (atomic_load(&executor->shutdown)) {
+        pthread_mutex_unlock(&executor->injection.mutex); // Rifiutato: il messaggio resta al chiamante
+        return BUFFER_ERROR;
+    }
+    atomic_fetch_add_explicit(&executor->submitted, 1, memory_order_relaxed);
+    annuncia_lavoro(executor);
+    deque_push_locked(&executor->injection, msg);
+    pthread_mutex_unlock(&executor->injection.mutex);
+
+    notifica_lavoro(executor);
+
+    return msg;
+}
+
+// Chiude il pool dopo aver eseguito tutti i task accettati
+void executor_shutdown(executor_t* executor) {
+    if (atomic_exchange(&executor->joined, true)) {
+        return;
+    }
+
+    // Da qui nessun task esterno viene più accettato; le sottomissioni
+    // sospese su una coda piena si risvegliano e lo rifiutano
+    pthread_mutex_lock(&executor->injection.mutex);
+    atomic_store(&executor->shutdown, true);
+    pthread_cond_broadcast(&executor->injection_not_full);
+    pthread_mutex_unlock(&executor->injection.mutex);
+
+    pthread_mutex_lock(&executor->park_mutex);
+    pthread_cond_broadcast(&executor->has_work);
+    pthread_mutex_unlock(&executor->park_mutex);
+
+    // I worker terminano solo senza task annunciati
+    for (unsigned int i = 0; i < executor->num_workers; i++) {
+        pthread_join(executor->workers[i].thread, NULL);
+    }
+
+    // Senza worker (num_workers == 0) i task accettati vengono eseguiti dal chiamante
+    msg_t* msg;
+    while ((msg = preleva_iniettato(executor)) != NULL) {
+        atomic_fetch_sub(&executor->pending, 1);
+        executor->task(msg, executor->task_arg);
+        atomic_fetch_add_explicit(&executor->drained, 1, memory_order_relaxed);
+    }
+}
+
+// Dealloca tutte le risorse del pool
+void executor_destroy(executor_t* executor) {
+    executor_shutdown(executor);
+
+    for (unsigned int i = 0; i < executor->num_workers; i++) {
+        free(executor->workers[i].deque.tasks);
+        pthread_mutex_destroy(&executor->workers[i].deque.mutex);
+    }
+
+    free(executor->injection.tasks);
+    pthread_mutex_destroy(&executor->injection.mutex);
+    pthread_cond_destroy(&executor->injection_not_full);
+    pthread_mutex_destroy(&executor->park_mutex);
+    pthread_cond_destroy(&executor->has_work);
+    free(executor->workers);
+    free(executor);
+}
+
+// Aggrega le statistiche di tutti i worker
+void executor_stats(executor_t* executor, executor_stats_t* stats) {
+    stats->submitted = atomic_load_explicit(&executor->submitted, memory_order_relaxed);
+    stats->executed = atomic_load_explicit(&executor->drained, memory_order_relaxed);
+    stats->local = 0;
+    stats->injected = 0;
+    stats->stolen = 0;
+    stats->parks = 0;
+
+    for (unsigned int i = 0; i < executor->num_workers; i++) {
+        executor_worker_t* worker = &executor->workers[i];
+        stats->executed += atomic_load_explicit(&worker->executed, memory_order_relaxed);
+        stats->local += atomic_load_explicit(&worker->local, memory_order_relaxed);
+        stats->injected += atomic_load_explicit(&worker->injected, memory_order_relaxed);
+        stats->stolen += atomic_load_explicit(&worker->stolen, memory_order_relaxed);
+        stats->parks += atomic_load_explicit(&worker->parks, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "buffer.h"
+#include "message.h"
+
+// funzione eseguita dai worker per ogni task: riceve il messaggio
+// e ne diventa responsabile, come un consumatore dopo get_bloccante
+typedef void (*executor_task_t)(msg_t* msg, void* arg);
+
+// deque locale di un worker: il proprietario inserisce ed estrae
+// in coda (LIFO), gli altri worker rubano dalla testa (FIFO); la
+// stessa struttura, estratta solo dalla testa, è la coda di iniezione
+typedef struct executor_deque {
+    msg_t** tasks;
+    unsigned int capacity;   // potenza di 2: gli indici restano validi anche quando head e tail si azzerano
+    unsigned int head;       // indice assoluto del task più vecchio
+    unsigned int tail;       // indice assoluto successivo al più recente
+    pthread_mutex_t mutex;
+} executor_deque_t;
+
+// statistiche del pool, aggregate su tutti i worker
+typedef struct executor_stats {
+    unsigned long submitted; // task accettati
+    unsigned long executed;  // task eseguiti
+    unsigned long local;     // presi dalla propria deque
+    unsigned long injected;  // presi dalla coda condivisa
+    unsigned long stolen;    // rubati alla deque di un altro worker
+    unsigned long parks;     // sospensioni di worker inattivi
+} executor_stats_t;
+
+struct executor;
+
+typedef struct executor_worker {
+    struct executor* executor;
+    unsigned int id;
+    pthread_t thread;
+    executor_deque_t deque;
+    atomic_ulong executed;
+    atomic_ulong local;
+    atomic_ulong injected;
+    atomic_ulong stolen;
+    atomic_ulong parks;
+} executor_worker_t;
+
+typedef struct executor {
+    executor_worker_t* workers;
+    unsigned int num_workers;
+    executor_deque_t injection;  // coda condivisa dei produttori esterni, in ordine di arrivo (FIFO)
+    pthread_cond_t injection_not_full;
+    executor_task_t task;
+    void* task_arg;
+    atomic_uint pending;         // task annunciati e non ancora presi
+    atomic_uint parked;          // worker sospesi in attesa di lavoro
+    atomic_bool shutdown;        // scritto con il mutex della coda di iniezione acquisito
+    atomic_ulong submitted;
+    atomic_ulong drained;        // task eseguiti da executor_shutdown dopo l'uscita dei worker
+    pthread_mutex_t park_mutex;
+    pthread_cond_t has_work;
+    atomic_bool joined;          // executor_shutdown già avviata
+} executor_t;
+
+/* allocazione / deallocazione executor */
+
+// creazione di un pool di num_workers thread, ciascuno con una deque
+// locale di deque_size task; i produttori esterni condividono una
+// coda di iniezione di injection_size task (entrambe le dimensioni
+// sono arrotondate alla potenza di 2 successiva)
+executor_t* executor_init(unsigned int num_workers, unsigned int deque_size, unsigned int injection_size,
+                          executor_task_t task, void* task_arg);
+
+// chiusura del pool: rifiuta nuovi task esterni, esegue tutti quelli
+// già accettati e attende la terminazione dei worker
+void executor_shutdown(executor_t* executor);
+
+// deallocazione del pool (esegue executor_shutdown se necessario)
+void executor_destroy(executor_t* executor);
+
+/* operazioni sull'executor */
+
+// sottomissione di un task: dall'interno di un worker finisce nella
+// deque locale, dall'esterno nella coda di iniezione (bloccante se
+// piena); restituisce il messaggio sottomesso, oppure BUFFER_ERROR
+// se il pool è in chiusura, anche se la chiusura avviene mentre la
+// sottomissione è sospesa (il messaggio resta al chiamante); N.B.: msg!=null
+msg_t* executor_submit(executor_t* executor, msg_t* msg);
+
+// lettura delle statistiche del pool
+void executor_stats(executor_t* executor, executor_stats_t* stats);
+
+#endif // EXECUTOR_H
@@ -0,0 +1,311 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "keyed_buffer.h"
+
+// Partizione associata ad una chiave
+static unsigned int partizione_di(keyed_buffer_t* buffer, unsigned long key) {
+    // Moltiplicazione di Fibonacci: chiavi consecutive finiscono in partizioni diverse
+    unsigned long long hash = (unsigned long long) key * 11400714819323198485ULL;
+    return (unsigned int) ((hash >> 32) % buffer->num_partitions);
+}
+
+// Ridistribuisce le partizioni tra i consumatori attivi (mutex acquisito)
+static void ribilancia(keyed_buffer_t* buffer) {
+    int* active_ids = (int*) malloc(sizeof(int) * buffer->max_consumers);
+    unsigned int n = 0;
+
+    for (unsigned int c = 0; c < buffer->max_consumers; c++) {
+        if (buffer->active[c]) {
+            active_ids[n++] = (int) c;
+        }
+    }
+
+    // Una partizione occupata cambia proprietario ma resta al consumatore
+    // precedente finché questi non conclude il messaggio in elaborazione
+    for (unsigned int p = 0; p < buffer->num_partitions; p++) {
+        buffer->partitions[p].owner = n > 0 ? active_ids[p % n] : KEYED_NO_CONSUMER;
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+        pthread_cond_signal(&buffer->has_work[active_ids[i]]);
+    }
+
+    free(active_ids);
+}
+
+// Libera la partizione in elaborazione del consumatore (mutex acquisito)
+static void rilascia(keyed_buffer_t* buffer, int consumer) {
+    int p = buffer->in_flight[consumer];
+
+    if (p != KEYED_NO_CONSUMER) {
+        keyed_partition_t* partition = &buffer->partitions[p];
+        partition->busy = KEYED_NO_CONSUMER;
+        buffer->in_flight[consumer] = KEYED_NO_CONSUMER;
+
+        // Dopo un ribilanciamento la partizione può aspettare un altro consumatore
+        if (partition->count > 0 && partition->owner != KEYED_NO_CONSUMER && partition->owner != consumer) {
+            pthread_cond_signal(&buffer->has_work[partition->owner]);
+        }
+    }
+}
+
+// Raddoppia la coda piena di una partizione, senza superare max_size (mutex acquisito)
+static void espandi(keyed_buffer_t* buffer, keyed_partition_t* partition) {
+    unsigned int capacity = partition->capacity * 2 < buffer->max_size ? partition->capacity * 2 : buffer->max_size;
+    msg_t** messages = (msg_t**) malloc(sizeof(msg_t*) * capacity);
+
+    // I messaggi vengono ricopiati in ordine a partire dall'inizio
+    for (unsigned int i = 0; i < partition->count; i++) {
+        messages[i] = partition->messages[(partition->head + i) % partition->capacity];
+    }
+
+    free(partition->messages);
+    partition->messages = messages;
+    partition->capacity = capacity;
+    partition->head = 0;
+}
+
+// Inserisce in coda alla partizione della chiave (mutex acquisito, buffer non pieno)
+static void inserisci(keyed_buffer_t* buffer, unsigned long key, msg_t* msg) {
+    keyed_partition_t* partition = &buffer->partitions[partizione_di(buffer, key)];
+
+    // Il buffer non è pieno: la partizione ha meno di max_size messaggi
+    if (partition->count == partition->capacity) {
+        espandi(buffer, partition);
+    }
+
+    partition->messages[(partition->head + partition->count) % partition->capacity] = msg;
+    partition->count++;
+    buffer->current_size++;
+
+    if (partition->owner != KEYED_NO_CONSUMER) {
+        pthread_cond_signal(&buffer->has_work[partition->owner]); // Segnala il consumatore assegnato
+    }
+}
+
+// Estrae dalla prima partizione libera e non vuota del consumatore (mutex acquisito)
+static msg_t* estrai(keyed_buffer_t* buffer, int consumer) {
+    unsigned int start = buffer->cursor[consumer];
+
+    for (unsigned int i = 0; i < buffer->num_partitions; i++) {
+        unsigned int p = (start + i) % buffer->num_partitions;
+        keyed_partition_t* partition = &buffer->partitions[p];
+
+        if (partition->owner == consumer && partition->busy == KEYED_NO_CONSUMER && partition->count > 0) {
+            msg_t* msg = partition->messages[partition->head];
+            partition->head = (partition->head + 1) % partition->capacity;
+            partition->count--;
+            partition->busy = consumer;
+            buffer->in_flight[consumer] = (int) p;
+            buffer->current_size--;
+
+            // La prossima estrazione riparte dalla partizione successiva
+            buffer->cursor[consumer] = (p + 1) % buffer->num_partitions;
+            pthread_cond_signal(&buffer->is_not_full); // Segnala che non è più pieno
+            return msg;
+        }
+    }
+
+    return BUFFER_ERROR;
+}
+
+// Inizializza un buffer partizionato per chiave
+keyed_buffer_t* keyed_buffer_init(unsigned int max_size, unsigned int num_partitions, unsigned int max_consumers) {
+    keyed_buffer_t* buffer = (keyed_buffer_t*) malloc(sizeof(keyed_buffer_t));
+    buffer->partitions = (keyed_partition_t*) malloc(sizeof(keyed_partition_t) * num_partitions);
+    buffer->num_partitions = num_partitions;
+    buffer->max_size = max_size;
+    buffer->current_size = 0;
+    buffer->active = (bool*) malloc(sizeof(bool) * max_consumers);
+    buffer->generation = (unsigned int*) malloc(sizeof(unsigned int) * max_consumers);
+    buffer->in_flight = (int*) malloc(sizeof(int) * max_consumers);
+    buffer->cursor = (unsigned int*) malloc(sizeof(unsigned int) * max_consumers);
+    buffer->has_work = (pthread_cond_t*) malloc(sizeof(pthread_cond_t) * max_consumers);
+    buffer->max_consumers = max_consumers;
+    buffer->num_consumers = 0;
+
+    // Ogni partizione può contenere, al limite, tutti i messaggi del buffer:
+    // la coda parte piccola e cresce solo se servono più posti
+    unsigned int capacity = max_size < KEYED_PARTITION_MIN_CAPACITY ? max_size : KEYED_PARTITION_MIN_CAPACITY;
+    for (unsigned int p = 0; p < num_partitions; p++) {
+        buffer->partitions[p].messages = (msg_t**) malloc(sizeof(msg_t*) * capacity);
+        buffer->partitions[p].capacity = capacity;
+        buffer->partitions[p].head = 0;
+        buffer->partitions[p].count = 0;
+        buffer->partitions[p].owner = KEYED_NO_CONSUMER;
+        buffer->partitions[p].busy = KEYED_NO_CONSUMER;
+    }
+
+    if (pthread_mutex_init(&buffer->mutex, NULL) != 0) {
+        perror("Mutex initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_cond_init(&buffer->is_not_full, NULL) != 0) {
+        perror("Condition variables initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned int c = 0; c < max_consumers; c++) {
+        buffer->active[c] = false;
+        buffer->generation[c] = 0;
+        buffer->in_flight[c] = KEYED_NO_CONSUMER;
+        buffer->cursor[c] = 0;
+        if (pthread_cond_init(&buffer->has_work[c], NULL) != 0) {
+            perror("Condition variables initialization failed!");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return buffer;
+}
+
+// Dealloca tutte le risorse del buffer
+void keyed_buffer_destroy(keyed_buffer_t* buffer) {
+    // Distrugge i messaggi rimanenti usando il loro distruttore specifico
+    for (unsigned int p = 0; p < buffer->num_partitions; p++) {
+        keyed_partition_t* partition = &buffer->partitions[p];
+        while (partition->count > 0) {
+            msg_t* msg_to_destroy = partition->messages[partition->head];
+            partition->head = (partition->head + 1) % partition->capacity;
+            partition->count--;
+            msg_to_destroy->msg_destroy(msg_to_destroy);
+        }
+        free(partition->messages);
+    }
+
+    for (unsigned int c = 0; c < buffer->max_consumers; c++) {
+        pthread_cond_destroy(&buffer->has_work[c]);
+    }
+
+    free(buffer->partitions);
+    free(buffer->active);
+    free(buffer->generation);
+    free(buffer->in_flight);
+    free(buffer->cursor);
+    free(buffer->has_work);
+    pthread_mutex_destroy(&buffer->mutex);
+    pthread_cond_destroy(&buffer->is_not_full);
+    free(buffer);
+}
+
+// Registra un consumatore e ribilancia le partizioni
+int keyed_buffer_join(keyed_buffer_t* buffer) {
+    int consumer = KEYED_NO_CONSUMER;
+
+    pthread_mutex_lock(&buffer->mutex);
+    for (unsigned int c = 0; c < buffer->max_consumers; c++) {
+        if (!buffer->active[c]) {
+            consumer = (int) c;
+            buffer->active[c] = true;
+            buffer->in_flight[c] = KEYED_NO_CONSUMER;
+            buffer->num_consumers++;
+            ribilancia(buffer);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&buffer->mutex);
+
+    return consumer;
+}
+
+// Vero se consumer è un identificativo valido di un consumatore registrato, mutex acquisito
+static bool registrato(keyed_buffer_t* buffer, int consumer) {
+    return consumer >= 0 && (unsigned int) consumer < buffer->max_consumers && buffer->active[consumer];
+}
+
+// Deregistra un consumatore e ribilancia le partizioni
+void keyed_buffer_leave(keyed_buffer_t* buffer, int consumer) {
+    pthread_mutex_lock(&buffer->mutex);
+    if (registrato(buffer, consumer)) {
+        buffer->active[consumer] = false;
+        buffer->generation[consumer]++; // Le get sospese non servono un consumatore che riusa l'identificativo
+        buffer->num_consumers--;
+        ribilancia(buffer);
+        rilascia(buffer, consumer);
+        pthread_cond_broadcast(&buffer->has_work[consumer]); // Sblocca una sua get sospesa
+    }
+    pthread_mutex_unlock(&buffer->mutex);
+}
+
+// Inserisce un messaggio, bloccante se il buffer è pieno
+msg_t* put_keyed_bloccante(keyed_buffer_t* buffer, unsigned long key, msg_t* msg) {
+    if (msg != NULL) {
+        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+        // Attende finché il buffer non è più pieno
+        while (buffer->current_size >= buffer->max_size) {
+            pthread_cond_wait(&buffer->is_not_full, &buffer->mutex);
+        }
+
+        inserisci(buffer, key, msg);
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+    }
+
+    return msg;
+}
+
+// Inserisce un messaggio, non bloccante (fallisce se il buffer è pieno)
+msg_t* put_keyed_non_bloccante(keyed_buffer_t* buffer, unsigned long key, msg_t* msg) {
+    if (msg != NULL) {
+        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+        if (buffer->current_size >= buffer->max_size) {
+            pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+            return BUFFER_ERROR;
+        }
+
+        inserisci(buffer, key, msg);
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+    }
+
+    return msg;
+}
+
+// Estrae un messaggio per il consumatore, bloccante se non ce ne sono
+msg_t* get_keyed_bloccante(keyed_buffer_t* buffer, int consumer) {
+    msg_t* msg = BUFFER_ERROR;
+
+    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+    if (!registrato(buffer, consumer)) {
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+        return BUFFER_ERROR;
+    }
+    rilascia(buffer, consumer);
+
+    // Attende un messaggio in una propria partizione libera, finché il consumatore non esce
+    unsigned int generation = buffer->generation[consumer];
+    while (buffer->generation[consumer] == generation && (msg = estrai(buffer, consumer)) == BUFFER_ERROR) {
+        pthread_cond_wait(&buffer->has_work[consumer], &buffer->mutex);
+    }
+
+    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Estrae un messaggio per il consumatore, non bloccante
+msg_t* get_keyed_non_bloccante(keyed_buffer_t* buffer, int consumer) {
+    msg_t* msg = BUFFER_ERROR;
+
+    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+    if (registrato(buffer, consumer)) {
+        rilascia(buffer, consumer);
+        msg = estrai(buffer, consumer);
+    }
+
+    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Conclude il messaggio in elaborazione del consumatore
+void keyed_buffer_done(keyed_buffer_t* buffer, int consumer) {
+    pthread_mutex_lock(&buffer->mutex);
+    if (registrato(buffer, consumer)) {
+        rilascia(buffer, consumer);
+    }
+    pthread_mutex_unlock(&buffer->mutex);
+}
@@ -0,0 +1,93 @@
+#ifndef KEYED_BUFFER_H
+#define KEYED_BUFFER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "buffer.h"
+#include "message.h"
+
+#define KEYED_NO_CONSUMER (-1)
+
+// capacità iniziale della coda di una partizione
+#define KEYED_PARTITION_MIN_CAPACITY 16
+
+// partizione: coda FIFO dei messaggi le cui chiavi vi sono associate
+typedef struct keyed_partition {
+    msg_t** messages;        // coda circolare, raddoppiata quando piena (al più max_size)
+    unsigned int capacity;
+    unsigned int head;
+    unsigned int count;
+    int owner;               // consumatore assegnato, KEYED_NO_CONSUMER se nessuno
+    int busy;                // consumatore che elabora un suo messaggio, KEYED_NO_CONSUMER se libera
+} keyed_partition_t;
+
+typedef struct keyed_buffer {
+    keyed_partition_t* partitions;
+    unsigned int num_partitions;
+    unsigned int max_size;   // messaggi complessivi su tutte le partizioni
+    unsigned int current_size;
+    bool* active;            // consumatori registrati
+    unsigned int* generation; // incrementata ad ogni uscita del consumatore
+    int* in_flight;          // partizione in elaborazione per consumatore
+    unsigned int* cursor;    // prossima partizione da esaminare per consumatore
+    pthread_cond_t* has_work; // una variabile di condizione per consumatore
+    unsigned int max_consumers;
+    unsigned int num_consumers;
+    pthread_mutex_t mutex;
+    pthread_cond_t is_not_full;
+} keyed_buffer_t;
+
+/* allocazione / deallocazione buffer */
+
+// creazione di un buffer vuoto di dim. max nota, con le chiavi
+// distribuite su num_partitions partizioni e fino a max_consumers
+// consumatori registrati contemporaneamente; la coda di una partizione
+// parte da KEYED_PARTITION_MIN_CAPACITY posti e cresce fino al massimo
+// numero di messaggi contenuti insieme (non si riduce)
+keyed_buffer_t* keyed_buffer_init(unsigned int max_size, unsigned int num_partitions, unsigned int max_consumers);
+
+// deallocazione di un buffer
+void keyed_buffer_destroy(keyed_buffer_t* buffer);
+
+/* consumatori */
+
+// registrazione di un consumatore: le partizioni vengono ridistribuite
+// tra i consumatori attivi; restituisce l'identificativo del consumatore
+// oppure KEYED_NO_CONSUMER se sono già registrati max_consumers consumatori;
+// l'identificativo di un consumatore uscito può essere riassegnato
+int keyed_buffer_join(keyed_buffer_t* buffer);
+
+// uscita di un consumatore: rilascia il messaggio in elaborazione,
+// ridistribuisce le sue partizioni e sblocca una sua get sospesa, che
+// restituisce BUFFER_ERROR anche se l'identificativo è già stato riassegnato
+void keyed_buffer_leave(keyed_buffer_t* buffer, int consumer);
+
+/* operazioni sul buffer */
+
+// inserimento bloccante nella partizione della chiave key: sospende
+// se il buffer è pieno; restituisce il messaggio inserito; N.B.: msg!=null
+msg_t* put_keyed_bloccante(keyed_buffer_t* buffer, unsigned long key, msg_t* msg);
+
+// inserimento non bloccante: restituisce BUFFER_ERROR se pieno,
+// altrimenti il messaggio inserito; N.B.: msg!=null
+msg_t* put_keyed_non_bloccante(keyed_buffer_t* buffer, unsigned long key, msg_t* msg);
+
+// estrazione bloccante per il consumatore consumer: dichiara concluso
+// il messaggio estratto in precedenza, quindi restituisce il più vecchio
+// messaggio di una sua partizione libera; messaggi con la stessa chiave
+// vengono consegnati in ordine ed a un solo consumatore alla volta;
+// restituisce BUFFER_ERROR se consumer non è un consumatore (più)
+// registrato, compresi identificativi fuori da [0, max_consumers)
+msg_t* get_keyed_bloccante(keyed_buffer_t* buffer, int consumer);
+
+// estrazione non bloccante: restituisce BUFFER_ERROR se nessuna
+// partizione del consumatore ha messaggi disponibili o se consumer
+// non è registrato
+msg_t* get_keyed_non_bloccante(keyed_buffer_t* buffer, int consumer);
+
+// dichiara concluso il messaggio estratto dal consumatore senza
+// estrarne un altro, liberandone la partizione; nessun effetto se
+// consumer non è registrato (vale anche per keyed_buffer_leave)
+void keyed_buffer_done(keyed_buffer_t* buffer, int consumer);
+
+#endif // KEYED_BUFFER_H
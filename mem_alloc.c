@@ -0,0 +1,168 @@
+#include <linux/mempolicy.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "mem_alloc.h"
+
+#define MEM_HUGEPAGE_SIZE (2UL * 1024 * 1024)
+#define MEM_MAX_NODES 1024
+
+// Intestazione posta davanti alla memoria restituita
+typedef struct mem_header {
+    void* base;      // inizio della mappatura
+    size_t length;   // lunghezza della mappatura
+} mem_header_t;
+
+// Spazio riservato all'intestazione: mantiene l'allineamento a cache line
+#define MEM_HEADER_SIZE 64
+
+// Arrotonda size al multiplo di align successivo
+static size_t arrotonda(size_t size, size_t align) {
+    return (size + align - 1) / align * align;
+}
+
+// Applica la politica NUMA alla mappatura; false se non è stato possibile
+// (nodo non valido, kernel senza supporto NUMA) e le pagine restano senza vincoli
+static bool applica_politica(void* addr, size_t length, const mem_alloc_opts_t* opts) {
+    unsigned long nodemask[MEM_MAX_NODES / (8 * sizeof(unsigned long))];
+    int mode;
+
+    memset(nodemask, 0, sizeof(nodemask));
+    if (opts->interleave) {
+        int nodes = mem_numa_nodes();
+        if (nodes > MEM_MAX_NODES) {
+            nodes = MEM_MAX_NODES;
+        }
+        for (int n = 0; n < nodes; n++) {
+            nodemask[n / (8 * sizeof(unsigned long))] |= 1UL << (n % (8 * sizeof(unsigned long)));
+        }
+        mode = MPOL_INTERLEAVE;
+    } else if (opts->numa_node == MEM_ANY_NODE) {
+        return true;
+    } else if (opts->numa_node < 0 || opts->numa_node >= MEM_MAX_NODES) {
+        return false; // Nodo non rappresentabile nella maschera
+    } else {
+        nodemask[opts->numa_node / (8 * sizeof(unsigned long))] |= 1UL << (opts->numa_node % (8 * sizeof(unsigned long)));
+        mode = MPOL_BIND;
+    }
+
+    // Le pagine non sono ancora state toccate: verranno allocate sui nodi scelti
+    return syscall(SYS_mbind, addr, length, mode, nodemask, (unsigned long) MEM_MAX_NODES, 0UL) == 0;
+}
+
+// Alloca memoria con vincoli NUMA e huge pages
+void* mem_alloc(size_t size, const mem_alloc_opts_t* opts) {
+    mem_alloc_opts_t defaults = { MEM_ANY_NODE, false, MEM_HUGEPAGES_NONE, NULL };
+    if (opts == NULL) {
+        opts = &defaults;
+    }
+
+    size_t length = size + MEM_HEADER_SIZE;
+    void* base = MAP_FAILED;
+
+    if (opts->hugepages == MEM_HUGEPAGES_EXPLICIT) {
+        length = arrotonda(length, MEM_HUGEPAGE_SIZE);
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+
+    if (base == MAP_FAILED && opts->hugepages != MEM_HUGEPAGES_NONE) {
+        // Huge pages trasparenti (o riservate non disponibili): mappatura allineata a 2MB
+        length = arrotonda(size + MEM_HEADER_SIZE, MEM_HUGEPAGE_SIZE);
+        size_t padded = length + MEM_HUGEPAGE_SIZE;
+        char* raw = (char*) mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return NULL;
+        }
+
+        char* aligned = (char*) arrotonda((uintptr_t) raw, MEM_HUGEPAGE_SIZE);
+        if (aligned > raw) {
+            munmap(raw, aligned - raw);
+        }
+        munmap(aligned + length, raw + padded - (aligned + length));
+        base = aligned;
+        madvise(base, length, MADV_HUGEPAGE);
+    }
+
+    if (base == MAP_FAILED) {
+        length = arrotonda(length, (size_t) sysconf(_SC_PAGESIZE));
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            return NULL;
+        }
+    }
+
+    if (!applica_politica(base, length, opts) && opts->numa_fallbacks != NULL) {
+        (*opts->numa_fallbacks)++;
+    }
+
+    mem_header_t* header = (mem_header_t*) base;
+    header->base = base;
+    header->length = length;
+
+    return (char*) base + MEM_HEADER_SIZE;
+}
+
+// Dealloca memoria ottenuta con mem_alloc
+void mem_free(void* ptr) {
+    if (ptr != NULL) {
+        mem_header_t* header = (mem_header_t*) ((char*) ptr - MEM_HEADER_SIZE);
+        munmap(header->base, header->length);
+    }
+}
+
+// Conta i nodi NUMA esposti dal kernel
+int mem_numa_nodes(void) {
+    int nodes = 0;
+    char path[64];
+
+    for (;;) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", nodes);
+        if (access(path, F_OK) != 0) {
+            break;
+        }
+        nodes++;
+    }
+
+    return nodes > 0 ? nodes : 1;
+}
+
+// Legge la lista di CPU del nodo (formato "0-3,8,10-11")
+int mem_node_cpus(int node, int* cpus, int max_cpus) {
+    char path[64];
+    char list[4096];
+    int count = 0;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    if (fgets(list, sizeof(list), file) == NULL) {
+        list[0] = '\0';
+    }
+    fclose(file);
+
+    char* cursor = list;
+    while (*cursor != '\0' && *cursor != '\n') {
+        char* end;
+        long first = strtol(cursor, &end, 10);
+        long last = first;
+        if (end == cursor) {
+            break;
+        }
+        if (*end == '-') {
+            cursor = end + 1;
+            last = strtol(cursor, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && count < max_cpus; cpu++) {
+            cpus[count++] = (int) cpu;
+        }
+        cursor = *end == ',' ? end + 1 : end;
+    }
+
+    return count;
+}
@@ -0,0 +1,38 @@
+#ifndef MEM_ALLOC_H
+#define MEM_ALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MEM_ANY_NODE (-1)
+
+// pagine usate per la memoria allocata
+typedef enum mem_hugepages {
+    MEM_HUGEPAGES_NONE,        // pagine normali
+    MEM_HUGEPAGES_TRANSPARENT, // transparent huge pages (madvise)
+    MEM_HUGEPAGES_EXPLICIT     // huge pages riservate (MAP_HUGETLB), transparent huge pages se non disponibili
+} mem_hugepages_t;
+
+// opzioni di allocazione per memoria di buffer e messaggi
+typedef struct mem_alloc_opts {
+    int numa_node;             // nodo a cui vincolare le pagine, MEM_ANY_NODE per nessun vincolo
+    bool interleave;           // distribuisce le pagine su tutti i nodi (ignora numa_node)
+    mem_hugepages_t hugepages;
+    unsigned long* numa_fallbacks; // se non NULL, incrementato quando il vincolo NUMA non viene applicato
+} mem_alloc_opts_t;
+
+// allocazione di size byte secondo le opzioni (NULL: nessun vincolo);
+// restituisce NULL se la memoria non può essere mappata
+void* mem_alloc(size_t size, const mem_alloc_opts_t* opts);
+
+// deallocazione di memoria ottenuta con mem_alloc
+void mem_free(void* ptr);
+
+// numero di nodi NUMA del sistema (1 se non è NUMA)
+int mem_numa_nodes(void);
+
+// scrive in cpus (al più max_cpus) le CPU del nodo NUMA node;
+// restituisce quante sono, oppure -1 se il nodo non esiste
+int mem_node_cpus(int node, int* cpus, int max_cpus);
+
+#endif // MEM_ALLOC_H
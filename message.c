@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "message.h"
+#include "trace.h"
 
 msg_t* msg_init_string(void* content) {
     //viene creata una copia "privata" della stringa
@@ -18,6 +19,7 @@ msg_t* msg_init_string(void* content) {
 }
 
 void msg_destroy_string(msg_t* msg) {
+    trace_msg_destroyed(msg); // Fine dell'elaborazione, se campionato
     free(msg->content); // free copia privata
     free(msg);          // free struct
 }
@@ -0,0 +1,131 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "msg_batch.h"
+#include "trace.h"
+
+// Rilascia un riferimento al lotto, deallocandolo con l'ultimo
+static void rilascia_riferimento(msg_batch_t* batch) {
+    if (atomic_fetch_sub_explicit(&batch->refs, 1, memory_order_acq_rel) == 1) {
+        free(batch);
+    }
+}
+
+// Distrugge un messaggio del lotto: la memoria resta al lotto
+static void msg_destroy_batched(msg_t* msg) {
+    msg_batch_entry_t* entry = (msg_batch_entry_t*) ((char*) msg - offsetof(msg_batch_entry_t, msg));
+
+    trace_msg_destroyed(msg); // Fine dell'elaborazione, se campionato
+    rilascia_riferimento(entry->batch);
+}
+
+// Conta i \0 di data, 16 byte per confronto con SSE2
+static size_t conta_terminatori(const char* data, size_t length) {
+    size_t count = 0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) (data + i));
+        count += (size_t) __builtin_popcount((unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)));
+    }
+#endif
+
+    for (; i < length; i++) {
+        count += data[i] == '\0';
+    }
+
+    return count;
+}
+
+// Inizializza il messaggio successivo del lotto sulla stringa content
+static void collega(msg_batch_t* batch, unsigned int* next, char* content) {
+    msg_batch_entry_t* entry = &batch->entries[(*next)++];
+
+    // Le copie escono dal lotto: msg_copy_string usa msg_init
+    entry->batch = batch;
+    entry->msg.content     = content;
+    entry->msg.msg_init    = msg_init_string;
+    entry->msg.msg_destroy = msg_destroy_batched;
+    entry->msg.msg_copy    = msg_copy_string;
+}
+
+// Collega un messaggio ad ogni stringa della copia, trovando i \0 con SSE2
+static void collega_stringhe(msg_batch_t* batch, size_t length) {
+    char* strings = batch->strings;
+    unsigned int next = 0;
+    size_t start = 0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) (strings + i));
+        unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+
+        // Un bit per ogni \0 del blocco, dal meno significativo
+        while (mask != 0) {
+            collega(batch, &next, strings + start);
+            start = i + (size_t) __builtin_ctz(mask) + 1;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < length; i++) {
+        if (strings[i] == '\0') {
+            collega(batch, &next, strings + start);
+            start = i + 1;
+        }
+    }
+
+    // Ultima stringa non terminata: il \0 aggiunto in fondo alla copia
+    if (start < length) {
+        collega(batch, &next, strings + start);
+    }
+}
+
+// Crea un lotto di messaggi dalle stringhe di packed
+msg_batch_t* msg_batch_init_strings(const char* packed, size_t length) {
+    size_t count = conta_terminatori(packed, length);
+    if (length > 0 && packed[length - 1] != '\0') {
+        count++;
+    }
+
+    // Intestazione, messaggi e stringhe (+1 per \0 finale) in un solo blocco
+    size_t entries_offset = (sizeof(msg_batch_t) + 15) & ~(size_t) 15;
+    size_t strings_offset = entries_offset + sizeof(msg_batch_entry_t) * count;
+    msg_batch_t* batch = (msg_batch_t*) malloc(strings_offset + length + 1);
+    if (batch == NULL) {
+        perror("Message batch allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    batch->entries = (msg_batch_entry_t*) ((char*) batch + entries_offset);
+    batch->strings = (char*) batch + strings_offset;
+    batch->count = (unsigned int) count;
+    atomic_init(&batch->refs, batch->count + 1);
+
+    // Un'unica copia per tutte le stringhe
+    memcpy(batch->strings, packed, length);
+    batch->strings[length] = '\0';
+
+    collega_stringhe(batch, length);
+
+    return batch;
+}
+
+// Rilascia il lotto intero
+void msg_batch_release(msg_batch_t* batch) {
+    free(batch);
+}
+
+// Cede il lotto ai consumatori dei suoi messaggi
+void msg_batch_detach(msg_batch_t* batch) {
+    rilascia_riferimento(batch);
+}
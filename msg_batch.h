@@ -0,0 +1,41 @@
+#ifndef MSG_BATCH_H
+#define MSG_BATCH_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "message.h"
+
+// messaggio del lotto: il lotto di appartenenza precede il messaggio
+typedef struct msg_batch_entry {
+    struct msg_batch* batch;
+    msg_t msg;
+} msg_batch_entry_t;
+
+// lotto di messaggi stringa in un'unica allocazione: intestazione,
+// messaggi e copia delle stringhe; ogni messaggio è un msg_t ordinario
+typedef struct msg_batch {
+    msg_batch_entry_t* entries;
+    char* strings;           // copia privata delle stringhe, separate da \0
+    unsigned int count;
+    atomic_uint refs;        // messaggi non ancora distrutti + riferimento del creatore
+} msg_batch_t;
+
+// creazione di un lotto con un messaggio per ogni stringa di packed:
+// length byte di stringhe consecutive separate da \0 (l'ultima può non
+// essere terminata); un solo malloc ed una sola copia per tutto il lotto
+msg_batch_t* msg_batch_init_strings(const char* packed, size_t length);
+
+// messaggio i-esimo del lotto, nell'ordine delle stringhe
+static inline msg_t* msg_batch_msg(msg_batch_t* batch, unsigned int i) {
+    return &batch->entries[i].msg;
+}
+
+// rilascio del lotto intero in O(1), senza distruggere i messaggi uno
+// ad uno; N.B.: nessun messaggio del lotto può essere usato dopo
+void msg_batch_release(msg_batch_t* batch);
+
+// cessione del lotto ai consumatori: il creatore rinuncia al proprio
+// riferimento e la distruzione dell'ultimo messaggio dealloca il lotto
+void msg_batch_detach(msg_batch_t* batch);
+
+#endif // MSG_BATCH_H
@@ -0,0 +1,100 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "msg_pool.h"
+#include "trace.h"
+
+// Blocco del pool: il pool di appartenenza precede il messaggio e la stringa
+typedef struct msg_pool_block {
+    msg_pool_t* pool;
+    union {
+        msg_t msg;
+        void* next_free;     // blocco libero successivo
+    };
+    char content[];
+} msg_pool_block_t;
+
+// Restituisce il blocco del messaggio al suo pool
+static void msg_destroy_pooled(msg_t* msg) {
+    msg_pool_block_t* block = (msg_pool_block_t*) ((char*) msg - offsetof(msg_pool_block_t, msg));
+    msg_pool_t* pool = block->pool;
+
+    trace_msg_destroyed(msg); // Fine dell'elaborazione, se campionato
+
+    pthread_mutex_lock(&pool->mutex);
+    block->next_free = pool->free_list;
+    pool->free_list = block;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// Inizializza il pool e concatena tutti i blocchi liberi
+msg_pool_t* msg_pool_init(unsigned int num_blocks, size_t max_length, const mem_alloc_opts_t* opts) {
+    msg_pool_t* pool = (msg_pool_t*) malloc(sizeof(msg_pool_t));
+
+    // Blocchi allineati a 16 byte: +1 per \0 finale
+    pool->block_size = (sizeof(msg_pool_block_t) + max_length + 1 + 15) & ~(size_t) 15;
+    pool->max_length = max_length;
+    pool->num_blocks = num_blocks;
+    pool->fallbacks = 0;
+    pool->memory = (char*) mem_alloc(pool->block_size * num_blocks, opts);
+    if (pool->memory == NULL) {
+        perror("Message pool allocation failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+        perror("Mutex initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    // La prima scrittura di ogni blocco avviene qui: con un vincolo NUMA
+    // le pagine sono già sul nodo richiesto, senza vincolo su quello del chiamante
+    pool->free_list = NULL;
+    for (unsigned int i = num_blocks; i > 0; i--) {
+        msg_pool_block_t* block = (msg_pool_block_t*) (pool->memory + (size_t) (i - 1) * pool->block_size);
+        block->pool = pool;
+        block->next_free = pool->free_list;
+        pool->free_list = block;
+    }
+
+    return pool;
+}
+
+// Dealloca il pool
+void msg_pool_destroy(msg_pool_t* pool) {
+    mem_free(pool->memory);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+// Crea un messaggio stringa nel pool
+msg_t* msg_pool_init_string(msg_pool_t* pool, void* content) {
+    char* string = (char*) content;
+    size_t length = strlen(string);
+    msg_pool_block_t* block = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (length <= pool->max_length && pool->free_list != NULL) {
+        block = (msg_pool_block_t*) pool->free_list;
+        pool->free_list = block->next_free;
+    } else {
+        pool->fallbacks++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (block == NULL) {
+        return msg_init_string(content);
+    }
+
+    memcpy(block->content, string, length + 1); // +1 per \0 finale
+
+    // Le copie escono dal pool: msg_copy_string usa msg_init
+    block->msg.content     = block->content;
+    block->msg.msg_init    = msg_init_string;
+    block->msg.msg_destroy = msg_destroy_pooled;
+    block->msg.msg_copy    = msg_copy_string;
+
+    return &block->msg;
+}
@@ -0,0 +1,34 @@
+#ifndef MSG_POOL_H
+#define MSG_POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include "mem_alloc.h"
+#include "message.h"
+
+// pool di messaggi stringa preallocati in un'unica area di memoria,
+// vincolabile ad un nodo NUMA e su huge pages; ogni blocco contiene
+// il msg_t e la copia privata della stringa
+typedef struct msg_pool {
+    char* memory;            // area dei blocchi, ottenuta con mem_alloc
+    size_t block_size;
+    size_t max_length;       // lunghezza massima di una stringa nel pool
+    unsigned int num_blocks;
+    void* free_list;         // blocchi liberi, concatenati
+    unsigned long fallbacks; // messaggi allocati sullo heap (pool esaurito o stringa troppo lunga)
+    pthread_mutex_t mutex;
+} msg_pool_t;
+
+// creazione di un pool di num_blocks messaggi per stringhe lunghe
+// al più max_length caratteri (NULL: nessun vincolo di allocazione)
+msg_pool_t* msg_pool_init(unsigned int num_blocks, size_t max_length, const mem_alloc_opts_t* opts);
+
+// deallocazione del pool; N.B.: tutti i suoi messaggi devono essere già distrutti
+void msg_pool_destroy(msg_pool_t* pool);
+
+// creare un messaggio stringa nel pool: come msg_init_string, ma la
+// memoria proviene dal pool e msg_destroy ve la restituisce; se il
+// pool è esaurito o la stringa non ci sta ricade su msg_init_string
+msg_t* msg_pool_init_string(msg_pool_t* pool, void* content);
+
+#endif // MSG_POOL_H
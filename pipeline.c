@@ -0,0 +1,282 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pipeline.h"
+
+// Il marcatore di fine flusso non possiede risorse
+static void end_of_stream_destroy(msg_t* msg) {
+    (void) msg;
+}
+
+// Marcatore di fine flusso: condiviso, mai consegnato alle funzioni degli stadi
+static msg_t end_of_stream = { NULL, NULL, end_of_stream_destroy, NULL };
+
+// Nanosecondi trascorsi tra due istanti
+static unsigned long elapsed_ns(const struct timespec* from, const struct timespec* to) {
+    return (unsigned long) (to->tv_sec - from->tv_sec) * 1000000000UL + (unsigned long) to->tv_nsec
+        - (unsigned long) from->tv_nsec;
+}
+
+// Buffer in cui il segmento che termina con lo stadio last deposita i risultati
+static buffer_t* buffer_successivo(pipeline_t* pipeline, unsigned int last) {
+    if (last + 1 < pipeline->num_stages) {
+        return pipeline->stages[last + 1].input;
+    }
+    return pipeline->output;
+}
+
+// Fa attraversare al messaggio gli stadi del segmento e lo consegna al successivo
+static void elabora(pipeline_stage_t* head, msg_t* msg) {
+    pipeline_t* pipeline = head->pipeline;
+
+    for (unsigned int i = head->index; i <= head->segment_end && msg != NULL; i++) {
+        pipeline_stage_t* stage = &pipeline->stages[i];
+        struct timespec begin, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        msg = stage->fn(msg, stage->arg);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        atomic_fetch_add_explicit(&stage->processed, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stage->busy_ns, elapsed_ns(&begin, &end), memory_order_relaxed);
+    }
+
+    if (msg != NULL) {
+        put_bloccante(buffer_successivo(pipeline, head->segment_end), msg);
+    }
+}
+
+// Ciclo di un worker del segmento che inizia con lo stadio head
+static void* stage_loop(void* arg) {
+    pipeline_stage_t* head = (pipeline_stage_t*) arg;
+    pipeline_t* pipeline = head->pipeline;
+
+    for (;;) {
+        msg_t* msg = get_bloccante(head->input);
+
+        if (msg != &end_of_stream) {
+            elabora(head, msg);
+            continue;
+        }
+
+        // Il buffer è estratto in ordine LIFO: il marcatore può precedere
+        // messaggi ancora presenti, che vanno elaborati prima di terminare
+        while ((msg = get_non_bloccante(head->input)) != BUFFER_ERROR) {
+            if (msg != &end_of_stream) {
+                elabora(head, msg);
+            }
+        }
+
+        // Il marcatore torna nel buffer (ormai vuoto) per gli altri worker
+        put_bloccante(head->input, &end_of_stream);
+        break;
+    }
+
+    // L'ultimo worker del segmento propaga la chiusura a valle
+    if (atomic_fetch_sub(&head->running, 1) == 1) {
+        put_bloccante(buffer_successivo(pipeline, head->segment_end), &end_of_stream);
+    }
+
+    return NULL;
+}
+
+// Crea una pipeline vuota
+pipeline_t* pipeline_init(unsigned int output_size) {
+    pipeline_t* pipeline = (pipeline_t*) malloc(sizeof(pipeline_t));
+    pipeline->stages = NULL;
+    pipeline->num_stages = 0;
+    pipeline->output = buffer_init(output_size);
+    pipeline->started = false;
+    pipeline->closed = false;
+
+    return pipeline;
+}
+
+// Aggiunge uno stadio in coda
+int pipeline_add_stage(pipeline_t* pipeline, pipeline_stage_fn_t fn, void* arg,
+                       unsigned int num_workers, unsigned int input_size) {
+    // Con capacità 0 ogni inserimento resterebbe bloccato per sempre
+    if (input_size == 0 || pipeline->started) {
+        return -1;
+    }
+
+    pipeline->stages = (pipeline_stage_t*) realloc(pipeline->stages,
+                                                   sizeof(pipeline_stage_t) * (pipeline->num_stages + 1));
+
+    unsigned int index = pipeline->num_stages++;
+    pipeline_stage_t* stage = &pipeline->stages[index];
+    stage->pipeline = pipeline;
+    stage->index = index;
+    stage->fn = fn;
+    stage->arg = arg;
+    stage->num_workers = num_workers > 0 ? num_workers : 1;
+    stage->capacity = input_size;
+    stage->input = NULL;
+    stage->segment_end = index;
+    stage->threads = NULL;
+    atomic_init(&stage->running, 0);
+    atomic_init(&stage->processed, 0);
+    atomic_init(&stage->busy_ns, 0);
+
+    return (int) index;
+}
+
+// Raggruppa gli stadi in segmenti, crea i buffer ed avvia i worker
+void pipeline_start(pipeline_t* pipeline, bool fuse) {
+    unsigned int head = 0;
+
+    // Gli stadi vengono fusi nel segmento corrente solo se entrambi hanno un solo worker
+    for (unsigned int i = 0; i < pipeline->num_stages; i++) {
+        pipeline_stage_t* stage = &pipeline->stages[i];
+
+        if (fuse && i > 0 && stage->num_workers == 1 && pipeline->stages[head].num_workers == 1) {
+            pipeline->stages[head].segment_end = i;
+        } else {
+            head = i;
+            stage->input = buffer_init(stage->capacity);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &pipeline->start_time);
+    pipeline->started = true;
+
+    for (unsigned int i = 0; i < pipeline->num_stages; i++) {
+        pipeline_stage_t* stage = &pipeline->stages[i];
+        if (stage->input == NULL) {
+            continue;
+        }
+
+        stage->threads = (pthread_t*) malloc(sizeof(pthread_t) * stage->num_workers);
+        atomic_store(&stage->running, stage->num_workers);
+        for (unsigned int w = 0; w < stage->num_workers; w++) {
+            if (pthread_create(&stage->threads[w], NULL, stage_loop, stage) != 0) {
+                perror("Pipeline worker creation failed!");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+// Inserisce un messaggio nel primo stadio
+msg_t* pipeline_put(pipeline_t* pipeline, msg_t* msg) {
+    // Il buffer del primo stadio viene creato da pipeline_start
+    if (pipeline->num_stages == 0 || !pipeline->started) {
+        return BUFFER_ERROR;
+    }
+
+    return put_bloccante(pipeline->stages[0].input, msg);
+}
+
+// Chiude l'ingresso della pipeline
+msg_t* pipeline_close(pipeline_t* pipeline) {
+    if (pipeline->num_stages > 0 && !pipeline->started) {
+        return BUFFER_ERROR;
+    }
+
+    if (!pipeline->closed) {
+        pipeline->closed = true;
+        if (pipeline->num_stages > 0) {
+            put_bloccante(pipeline->stages[0].input, &end_of_stream);
+        } else {
+            put_bloccante(pipeline->output, &end_of_stream);
+        }
+    }
+
+    return NULL;
+}
+
+// Estrae un risultato dall'ultimo stadio
+msg_t* pipeline_get(pipeline_t* pipeline) {
+    msg_t* msg = get_bloccante(pipeline->output);
+
+    if (msg == &end_of_stream) {
+        // Risultati arrivati prima della chiusura possono trovarsi sotto il marcatore
+        msg = get_non_bloccante(pipeline->output);
+        put_bloccante(pipeline->output, &end_of_stream);
+    }
+
+    return msg;
+}
+
+// Legge le statistiche di uno stadio
+void pipeline_stats(pipeline_t* pipeline, unsigned int index, pipeline_stage_stats_t* stats) {
+    pipeline_stage_t* stage = &pipeline->stages[index];
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    double elapsed = (double) elapsed_ns(&pipeline->start_time, &now);
+    unsigned long busy = atomic_load_explicit(&stage->busy_ns, memory_order_relaxed);
+
+    // Uno stadio fuso usa i thread del segmento a cui appartiene
+    unsigned int head = index;
+    while (pipeline->stages[head].input == NULL) {
+        head--;
+    }
+
+    stats->processed = atomic_load_explicit(&stage->processed, memory_order_relaxed);
+    stats->throughput = elapsed > 0 ? stats->processed * 1e9 / elapsed : 0.0;
+    stats->utilization = elapsed > 0 ? busy / (elapsed * pipeline->stages[head].num_workers) : 0.0;
+    stats->fused = stage->input == NULL;
+    stats->capacity = stats->fused ? 0 : stage->capacity;
+    stats->occupancy = 0;
+
+    if (!stats->fused) {
+        sync_mutex_lock(&stage->input->mutex);
+        stats->occupancy = stage->input->current_size;
+        sync_mutex_unlock(&stage->input->mutex);
+
+        // Il marcatore di fine flusso non è un messaggio in attesa
+        if (stats->occupancy > 0 && atomic_load(&stage->running) == 0) {
+            stats->occupancy--;
+        }
+    }
+}
+
+// Dealloca la pipeline
+void pipeline_destroy(pipeline_t* pipeline) {
+    if (pipeline->started) {
+        msg_t* msg;
+
+        // Senza stadi il marcatore va direttamente nell'uscita
+        buffer_t* first = pipeline->num_stages > 0 ? pipeline->stages[0].input : pipeline->output;
+
+        // I risultati non consumati vengono distrutti, così nessun worker resta
+        // sospeso su un buffer pieno e il marcatore trova posto nel primo stadio
+        while (!pipeline->closed && put_non_bloccante(first, &end_of_stream) == BUFFER_ERROR) {
+            if ((msg = get_non_bloccante(pipeline->output)) != BUFFER_ERROR) {
+                msg->msg_destroy(msg);
+            } else {
+                sched_yield();
+            }
+        }
+        pipeline->closed = true;
+
+        while ((msg = pipeline_get(pipeline)) != BUFFER_ERROR) {
+            msg->msg_destroy(msg);
+        }
+
+        for (unsigned int i = 0; i < pipeline->num_stages; i++) {
+            pipeline_stage_t* stage = &pipeline->stages[i];
+            if (stage->threads != NULL) {
+                for (unsigned int w = 0; w < stage->num_workers; w++) {
+                    pthread_join(stage->threads[w], NULL);
+                }
+                free(stage->threads);
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < pipeline->num_stages; i++) {
+        if (pipeline->stages[i].input != NULL) {
+            buffer_destroy(pipeline->stages[i].input);
+        }
+    }
+
+    buffer_destroy(pipeline->output);
+    free(pipeline->stages);
+    free(pipeline);
+}
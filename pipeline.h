@@ -0,0 +1,92 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+#include "buffer.h"
+#include "message.h"
+
+// funzione di uno stadio: riceve il messaggio in ingresso (e ne diventa
+// responsabile) e restituisce il messaggio da passare allo stadio
+// successivo, oppure NULL per scartarlo
+typedef msg_t* (*pipeline_stage_fn_t)(msg_t* msg, void* arg);
+
+struct pipeline;
+
+typedef struct pipeline_stage {
+    struct pipeline* pipeline;
+    unsigned int index;
+    pipeline_stage_fn_t fn;
+    void* arg;
+    unsigned int num_workers;
+    unsigned int capacity;       // capacità del buffer in ingresso
+    buffer_t* input;             // NULL se fuso con lo stadio precedente
+    unsigned int segment_end;    // ultimo stadio eseguito dagli stessi thread
+    pthread_t* threads;
+    atomic_uint running;         // worker non ancora terminati
+    atomic_ulong processed;      // messaggi elaborati da fn
+    atomic_ulong busy_ns;        // tempo complessivo trascorso dentro fn
+} pipeline_stage_t;
+
+typedef struct pipeline {
+    pipeline_stage_t* stages;
+    unsigned int num_stages;
+    buffer_t* output;            // messaggi prodotti dall'ultimo stadio
+    bool started;
+    bool closed;
+    struct timespec start_time;
+} pipeline_t;
+
+// statistiche di uno stadio
+typedef struct pipeline_stage_stats {
+    unsigned long processed;     // messaggi elaborati
+    double throughput;           // messaggi al secondo dall'avvio
+    double utilization;          // frazione del tempo dei worker spesa in fn
+    unsigned int occupancy;      // messaggi in attesa nel buffer in ingresso
+    unsigned int capacity;       // capacità del buffer in ingresso (0 se fuso)
+    bool fused;                  // eseguito dai thread dello stadio precedente
+} pipeline_stage_stats_t;
+
+/* allocazione / deallocazione pipeline */
+
+// creazione di una pipeline vuota; i risultati dell'ultimo stadio
+// vengono raccolti in un buffer di capacità output_size
+pipeline_t* pipeline_init(unsigned int output_size);
+
+// deallocazione della pipeline: la chiude se necessario, attende la
+// terminazione dei worker e distrugge i messaggi rimasti nei buffer
+void pipeline_destroy(pipeline_t* pipeline);
+
+/* configurazione */
+
+// aggiunta in coda di uno stadio con num_workers thread ed un buffer
+// in ingresso di capacità input_size; restituisce l'indice dello stadio,
+// oppure -1 se input_size è 0 o la pipeline è già stata avviata
+int pipeline_add_stage(pipeline_t* pipeline, pipeline_stage_fn_t fn, void* arg,
+                       unsigned int num_workers, unsigned int input_size);
+
+// avvio dei worker; con fuse=true stadi adiacenti con un solo worker
+// ciascuno vengono eseguiti dallo stesso thread, senza buffer intermedio
+void pipeline_start(pipeline_t* pipeline, bool fuse);
+
+/* operazioni sulla pipeline */
+
+// inserimento bloccante nel primo stadio; N.B.: msg!=null
+// restituisce BUFFER_ERROR se la pipeline non ha stadi o non è avviata
+msg_t* pipeline_put(pipeline_t* pipeline, msg_t* msg);
+
+// chiusura dell'ingresso: gli stadi elaborano i messaggi rimasti e
+// terminano in ordine, dal primo all'ultimo; restituisce BUFFER_ERROR
+// se la pipeline ha stadi ma non è avviata, NULL altrimenti
+msg_t* pipeline_close(pipeline_t* pipeline);
+
+// estrazione bloccante di un risultato; restituisce BUFFER_ERROR
+// quando la pipeline è chiusa e completamente svuotata
+msg_t* pipeline_get(pipeline_t* pipeline);
+
+// lettura delle statistiche dello stadio index
+void pipeline_stats(pipeline_t* pipeline, unsigned int index, pipeline_stage_stats_t* stats);
+
+#endif // PIPELINE_H
@@ -0,0 +1,288 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "spill_buffer.h"
+
+// Ogni record è preceduto dalla sua lunghezza ed allineato a 8 byte
+#define SPILL_RECORD_HEADER sizeof(uint64_t)
+#define SPILL_RECORD_ALIGN(n) (((n) + 7) & ~(size_t) 7)
+
+static size_t spill_string_size(msg_t* msg) {
+    return strlen((char*) msg->content) + 1; // +1 per \0 finale
+}
+
+static void spill_string_write(msg_t* msg, void* out) {
+    memcpy(out, msg->content, strlen((char*) msg->content) + 1);
+}
+
+static msg_t* spill_string_read(const void* data, size_t length) {
+    (void) length;
+    return msg_init_string((void*) data); // Unica copia: dal segmento alla stringa privata
+}
+
+const spill_codec_t spill_codec_string = { spill_string_size, spill_string_write, spill_string_read };
+
+// Segnaposto restituito da put_spill al posto del messaggio distrutto
+msg_t spill_on_disk = { NULL, NULL, NULL, NULL };
+
+// Crea un nuovo segmento di almeno size byte, oppure ne riusa uno libero
+static spill_segment_t* apri_segmento(spill_buffer_t* buffer, size_t size) {
+    spill_segment_t* segment = buffer->free_segments;
+
+    if (segment != NULL && segment->size >= size) {
+        buffer->free_segments = segment->next;
+        buffer->num_free_segments--;
+        segment->write_offset = 0;
+        segment->read_offset = 0;
+        segment->next = NULL;
+        return segment;
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/spill-%08u.seg", buffer->directory, buffer->next_segment_id++);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        perror("Spill segment creation failed");
+        return NULL;
+    }
+
+    // Il file serve solo finché è mappato: rimosso subito, non sopravvive al processo
+    unlink(path);
+
+    // I blocchi vengono riservati ora: una scrittura nella mappatura non può fallire dopo
+    if (posix_fallocate(fd, 0, (off_t) size) != 0) {
+        perror("Spill segment allocation failed");
+        close(fd);
+        return NULL;
+    }
+
+    char* data = (char*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        perror("Spill segment mapping failed");
+        close(fd);
+        return NULL;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    segment = (spill_segment_t*) malloc(sizeof(spill_segment_t));
+    segment->fd = fd;
+    segment->data = data;
+    segment->size = size;
+    segment->write_offset = 0;
+    segment->read_offset = 0;
+    segment->next = NULL;
+
+    return segment;
+}
+
+// Chiude un segmento e ne rilascia le risorse
+static void chiudi_segmento(spill_segment_t* segment) {
+    munmap(segment->data, segment->size);
+    close(segment->fd);
+    free(segment);
+}
+
+// Ricicla un segmento completamente riletto
+static void ricicla_segmento(spill_buffer_t* buffer, spill_segment_t* segment) {
+    if (buffer->num_free_segments < buffer->max_free_segments && segment->size == buffer->segment_size) {
+        // Le pagine già rilette non servono più in memoria
+        madvise(segment->data, segment->size, MADV_DONTNEED);
+        segment->next = buffer->free_segments;
+        buffer->free_segments = segment;
+        buffer->num_free_segments++;
+    } else {
+        chiudi_segmento(segment);
+    }
+}
+
+// Serializza il messaggio in coda al log (mutex acquisito); false se lo spazio su disco è esaurito
+static bool scrivi_record(spill_buffer_t* buffer, msg_t* msg) {
+    size_t length = buffer->codec->size(msg);
+    size_t record = SPILL_RECORD_HEADER + SPILL_RECORD_ALIGN(length);
+    spill_segment_t* tail = buffer->tail;
+
+    if (tail != NULL && tail->write_offset + record > tail->size && buffer->spilled == 0) {
+        // Log vuoto: il segmento svuotato non deve restare in testa alla catena
+        buffer->head = NULL;
+        buffer->tail = NULL;
+        ricicla_segmento(buffer, tail);
+        tail = NULL;
+    }
+
+    if (tail == NULL || tail->write_offset + record > tail->size) {
+        // Un record più grande di un segmento ottiene un segmento su misura
+        size_t size = record > buffer->segment_size ? record : buffer->segment_size;
+        spill_segment_t* segment = apri_segmento(buffer, size);
+        if (segment == NULL) {
+            return false;
+        }
+
+        if (tail != NULL) {
+            tail->next = segment;
+        } else {
+            buffer->head = segment;
+        }
+        buffer->tail = tail = segment;
+    }
+
+    // Scrittura sequenziale direttamente nelle pagine mappate, senza system call
+    char* out = tail->data + tail->write_offset;
+    *(uint64_t*) out = length;
+    buffer->codec->write(msg, out + SPILL_RECORD_HEADER);
+    tail->write_offset += record;
+
+    buffer->spilled++;
+    buffer->total_spilled++;
+    return true;
+}
+
+// Rilegge il record più vecchio del log (mutex acquisito, log non vuoto)
+static msg_t* leggi_record(spill_buffer_t* buffer) {
+    spill_segment_t* head = buffer->head;
+    char* in = head->data + head->read_offset;
+    size_t length = (size_t) *(uint64_t*) in;
+
+    // Il codec legge direttamente dalla mappatura
+    msg_t* msg = buffer->codec->read(in + SPILL_RECORD_HEADER, length);
+    head->read_offset += SPILL_RECORD_HEADER + SPILL_RECORD_ALIGN(length);
+
+    buffer->spilled--;
+    buffer->total_replayed++;
+
+    if (head->read_offset == head->write_offset) {
+        if (head == buffer->tail) {
+            // Log vuoto: l'ultimo segmento si riscrive dall'inizio
+            head->read_offset = 0;
+            head->write_offset = 0;
+        } else {
+            buffer->head = head->next;
+            ricicla_segmento(buffer, head);
+        }
+    }
+
+    return msg;
+}
+
+// Estrae dalla memoria o dal log (mutex acquisito)
+static msg_t* estrai(spill_buffer_t* buffer) {
+    msg_t* msg = get_non_bloccante(buffer->memory);
+
+    if (msg == BUFFER_ERROR && buffer->spilled > 0) {
+        msg = leggi_record(buffer);
+    }
+
+    return msg;
+}
+
+// Inizializza un buffer con riversamento su disco
+spill_buffer_t* spill_buffer_init(unsigned int max_size, const char* directory, size_t segment_size,
+                                  unsigned int max_free_segments, const spill_codec_t* codec) {
+    spill_buffer_t* buffer = (spill_buffer_t*) malloc(sizeof(spill_buffer_t));
+    buffer->memory = buffer_init(max_size);
+    buffer->codec = codec;
+    buffer->directory = strdup(directory);
+    buffer->segment_size = segment_size;
+    buffer->max_free_segments = max_free_segments;
+    buffer->head = NULL;
+    buffer->tail = NULL;
+    buffer->free_segments = NULL;
+    buffer->num_free_segments = 0;
+    buffer->next_segment_id = 0;
+    buffer->spilled = 0;
+    buffer->total_spilled = 0;
+    buffer->total_replayed = 0;
+
+    if (pthread_mutex_init(&buffer->mutex, NULL) != 0) {
+        perror("Mutex initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_cond_init(&buffer->is_not_empty, NULL) != 0) {
+        perror("Condition variables initialization failed!");
+        exit(EXIT_FAILURE);
+    }
+
+    return buffer;
+}
+
+// Dealloca tutte le risorse del buffer
+void spill_buffer_destroy(spill_buffer_t* buffer) {
+    // I record su disco sono solo dati serializzati (l'originale è già stato
+    // distrutto): basta chiudere i segmenti, senza ricreare i messaggi
+    while (buffer->head != NULL) {
+        spill_segment_t* segment = buffer->head;
+        buffer->head = segment->next;
+        chiudi_segmento(segment);
+    }
+
+    while (buffer->free_segments != NULL) {
+        spill_segment_t* segment = buffer->free_segments;
+        buffer->free_segments = segment->next;
+        chiudi_segmento(segment);
+    }
+
+    buffer_destroy(buffer->memory);
+    free(buffer->directory);
+    pthread_mutex_destroy(&buffer->mutex);
+    pthread_cond_destroy(&buffer->is_not_empty);
+    free(buffer);
+}
+
+// Inserisce un messaggio in memoria o, se piena, sul log
+msg_t* put_spill(spill_buffer_t* buffer, msg_t* msg) {
+    if (msg != NULL) {
+        pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+        // Finché il log non è vuoto si accoda al log, per non scavalcarlo
+        if (buffer->spilled == 0 && put_non_bloccante(buffer->memory, msg) == msg) {
+            pthread_cond_signal(&buffer->is_not_empty); // Segnala che non è più vuoto
+            pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+            return msg;
+        }
+
+        if (!scrivi_record(buffer, msg)) {
+            pthread_mutex_unlock(&buffer->mutex); // Sblocca e ritorna errore
+            return BUFFER_ERROR;
+        }
+        pthread_cond_signal(&buffer->is_not_empty); // Segnala che non è più vuoto
+        pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+        // La copia serializzata sostituisce il messaggio
+        msg->msg_destroy(msg);
+        return SPILL_ON_DISK;
+    }
+
+    return msg;
+}
+
+// Estrae un messaggio, bloccante se memoria e log sono vuoti
+msg_t* get_spill_bloccante(spill_buffer_t* buffer) {
+    msg_t* msg;
+
+    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+
+    // Attende finché memoria e log non sono più vuoti
+    while ((msg = estrai(buffer)) == BUFFER_ERROR) {
+        pthread_cond_wait(&buffer->is_not_empty, &buffer->mutex);
+    }
+
+    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    return msg;
+}
+
+// Estrae un messaggio, non bloccante (fallisce se memoria e log sono vuoti)
+msg_t* get_spill_non_bloccante(spill_buffer_t* buffer) {
+    pthread_mutex_lock(&buffer->mutex); // Blocca l'accesso
+    msg_t* msg = estrai(buffer);
+    pthread_mutex_unlock(&buffer->mutex); // Sblocca l'accesso
+
+    return msg;
+}
@@ -0,0 +1,86 @@
+#ifndef SPILL_BUFFER_H
+#define SPILL_BUFFER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include "buffer.h"
+#include "message.h"
+
+// esito di put_spill per un messaggio riversato su disco (e distrutto)
+#define SPILL_ON_DISK (&spill_on_disk)
+
+extern msg_t spill_on_disk;
+
+// serializzazione dei messaggi riversati su disco
+// N.B.: read legge dalla mappatura del segmento senza passare da un buffer
+// intermedio, ma il segmento viene riusato appena riletto: il messaggio
+// ricreato deve copiare i dati e non può riferirsi alla mappatura
+typedef struct spill_codec {
+    size_t (*size)(msg_t* msg);                      // byte occupati dal messaggio serializzato
+    void (*write)(msg_t* msg, void* out);            // serializza il messaggio in out
+    msg_t* (*read)(const void* data, size_t length); // ricrea il messaggio copiando i dati dal segmento
+} spill_codec_t;
+
+// codec dei messaggi creati con msg_init_string: una sola copia per
+// messaggio, dal segmento alla stringa privata di msg_init_string
+extern const spill_codec_t spill_codec_string;
+
+// segmento del log: file su disco mappato in memoria
+typedef struct spill_segment {
+    int fd;
+    char* data;
+    size_t size;
+    size_t write_offset;     // fine dei record scritti
+    size_t read_offset;      // inizio del primo record non ancora riletto
+    struct spill_segment* next;
+} spill_segment_t;
+
+typedef struct spill_buffer {
+    buffer_t* memory;        // messaggi in memoria, finché c'è spazio
+    const spill_codec_t* codec;
+    char* directory;
+    size_t segment_size;
+    unsigned int max_free_segments;
+    spill_segment_t* head;   // segmento da cui si rilegge
+    spill_segment_t* tail;   // segmento in cui si scrive
+    spill_segment_t* free_segments;  // segmenti riletti, pronti per essere riusati
+    unsigned int num_free_segments;
+    unsigned int next_segment_id;
+    unsigned long spilled;   // messaggi attualmente su disco
+    unsigned long total_spilled;
+    unsigned long total_replayed;
+    pthread_mutex_t mutex;
+    pthread_cond_t is_not_empty;
+} spill_buffer_t;
+
+/* allocazione / deallocazione buffer */
+
+// creazione di un buffer vuoto con max_size messaggi in memoria; quando
+// è pieno i messaggi vengono serializzati con codec in segmenti da
+// segment_size byte creati nella directory directory; fino a
+// max_free_segments segmenti riletti vengono conservati per il riuso
+spill_buffer_t* spill_buffer_init(unsigned int max_size, const char* directory, size_t segment_size,
+                                  unsigned int max_free_segments, const spill_codec_t* codec);
+
+// deallocazione di un buffer: i messaggi in memoria vengono distrutti,
+// i record ancora su disco scartati senza passare dal codec
+void spill_buffer_destroy(spill_buffer_t* buffer);
+
+/* operazioni sul buffer */
+
+// inserimento che non sospende mai: in memoria se c'è spazio e il log
+// è vuoto, altrimenti il messaggio viene serializzato in coda al log e
+// distrutto; restituisce il messaggio se inserito in memoria,
+// SPILL_ON_DISK se riversato su disco (msg non è più valido), oppure
+// BUFFER_ERROR se lo spazio su disco è esaurito (il messaggio resta al
+// chiamante); N.B.: msg!=null
+msg_t* put_spill(spill_buffer_t* buffer, msg_t* msg);
+
+// estrazione bloccante: prima dalla memoria, poi rileggendo il log
+// nell'ordine di scrittura; sospende se entrambi sono vuoti
+msg_t* get_spill_bloccante(spill_buffer_t* buffer);
+
+// estrazione non bloccante: restituisce BUFFER_ERROR se vuoto
+msg_t* get_spill_non_bloccante(spill_buffer_t* buffer);
+
+#endif // SPILL_BUFFER_H
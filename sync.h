@@ -0,0 +1,166 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+/*
+ * Primitive di sincronizzazione di buffer_t.
+ *
+ * Per default sono un sottile strato sopra pthread (portabile).
+ * Compilando con -DBUFFER_FUTEX su Linux vengono invece usate
+ * direttamente le futex:
+ *  - il mutex è una parola a tre stati (0 libero, 1 occupato,
+ *    2 occupato con thread in attesa): lock/unlock senza contesa
+ *    non entrano mai nel kernel;
+ *  - ogni variabile di condizione è un contatore di sequenza: chi
+ *    attende ne legge il valore prima di rilasciare il mutex e dorme
+ *    solo se non è cambiato, quindi nessun risveglio va perso;
+ *  - signal e broadcast non svegliano chi attende ma lo spostano
+ *    (FUTEX_CMP_REQUEUE) sulla parola del mutex: verrà svegliato
+ *    dall'unlock, già pronto ad entrare nella sezione critica,
+ *    invece di svegliarsi, trovare il mutex occupato e riaddormentarsi.
+ * N.B.: signal e broadcast vanno chiamate con il mutex acquisito.
+ */
+
+#ifdef BUFFER_FUTEX
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define BUFFER_SYNC_BACKEND "futex"
+
+typedef struct sync_mutex {
+    atomic_int state;
+} sync_mutex_t;
+
+typedef struct sync_cond {
+    atomic_uint seq;
+    unsigned int waiters;    // protetto dal mutex associato
+} sync_cond_t;
+
+static inline long sync_futex(void* addr, int op, int val, unsigned long val2, void* addr2, int val3) {
+    return syscall(SYS_futex, addr, op, val, val2, addr2, val3);
+}
+
+static inline int sync_mutex_init(sync_mutex_t* mutex) {
+    atomic_init(&mutex->state, 0);
+    return 0;
+}
+
+static inline void sync_mutex_destroy(sync_mutex_t* mutex) {
+    (void) mutex;
+}
+
+// Acquisisce il mutex dichiarando che potrebbero esserci thread in attesa
+static inline void sync_mutex_lock_contended(sync_mutex_t* mutex) {
+    while (atomic_exchange(&mutex->state, 2) != 0) {
+        sync_futex(&mutex->state, FUTEX_WAIT_PRIVATE, 2, 0, NULL, 0);
+    }
+}
+
+static inline void sync_mutex_lock(sync_mutex_t* mutex) {
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&mutex->state, &expected, 1)) {
+        sync_mutex_lock_contended(mutex);
+    }
+}
+
+static inline void sync_mutex_unlock(sync_mutex_t* mutex) {
+    if (atomic_fetch_sub(&mutex->state, 1) != 1) {
+        atomic_store(&mutex->state, 0);
+        sync_futex(&mutex->state, FUTEX_WAKE_PRIVATE, 1, 0, NULL, 0);
+    }
+}
+
+static inline int sync_cond_init(sync_cond_t* cond) {
+    atomic_init(&cond->seq, 0);
+    cond->waiters = 0;
+    return 0;
+}
+
+static inline void sync_cond_destroy(sync_cond_t* cond) {
+    (void) cond;
+}
+
+static inline void sync_cond_wait(sync_cond_t* cond, sync_mutex_t* mutex) {
+    unsigned int seq = atomic_load(&cond->seq);
+    cond->waiters++;
+    sync_mutex_unlock(mutex);
+
+    sync_futex(&cond->seq, FUTEX_WAIT_PRIVATE, (int) seq, 0, NULL, 0);
+
+    // Altri thread possono essere stati spostati sul mutex insieme a questo
+    sync_mutex_lock_contended(mutex);
+    cond->waiters--;
+}
+
+// Sposta fino a count thread in attesa sulla parola del mutex
+static inline void sync_cond_requeue(sync_cond_t* cond, sync_mutex_t* mutex, int count) {
+    unsigned int seq = atomic_fetch_add(&cond->seq, 1) + 1;
+
+    if (cond->waiters > 0) {
+        // L'unlock deve sapere che ci sono thread da svegliare
+        atomic_store(&mutex->state, 2);
+        sync_futex(&cond->seq, FUTEX_CMP_REQUEUE_PRIVATE, 0, (unsigned long) count, &mutex->state, (int) seq);
+    }
+}
+
+static inline void sync_cond_signal(sync_cond_t* cond, sync_mutex_t* mutex) {
+    sync_cond_requeue(cond, mutex, 1);
+}
+
+static inline void sync_cond_broadcast(sync_cond_t* cond, sync_mutex_t* mutex) {
+    sync_cond_requeue(cond, mutex, INT_MAX);
+}
+
+#else // BUFFER_FUTEX
+
+#include <pthread.h>
+
+#define BUFFER_SYNC_BACKEND "pthread"
+
+typedef pthread_mutex_t sync_mutex_t;
+typedef pthread_cond_t sync_cond_t;
+
+static inline int sync_mutex_init(sync_mutex_t* mutex) {
+    return pthread_mutex_init(mutex, NULL);
+}
+
+static inline void sync_mutex_destroy(sync_mutex_t* mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+static inline void sync_mutex_lock(sync_mutex_t* mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+static inline void sync_mutex_unlock(sync_mutex_t* mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+static inline int sync_cond_init(sync_cond_t* cond) {
+    return pthread_cond_init(cond, NULL);
+}
+
+static inline void sync_cond_destroy(sync_cond_t* cond) {
+    pthread_cond_destroy(cond);
+}
+
+static inline void sync_cond_wait(sync_cond_t* cond, sync_mutex_t* mutex) {
+    pthread_cond_wait(cond, mutex);
+}
+
+static inline void sync_cond_signal(sync_cond_t* cond, sync_mutex_t* mutex) {
+    (void) mutex;
+    pthread_cond_signal(cond);
+}
+
+static inline void sync_cond_broadcast(sync_cond_t* cond, sync_mutex_t* mutex) {
+    (void) mutex;
+    pthread_cond_broadcast(cond);
+}
+
+#endif // BUFFER_FUTEX
+
+#endif // SYNC_H
@@ -9,6 +9,7 @@
 
 #include "buffer.h"
 #include "message.h"
+#include "msg_pool.h"
 
 // === Funzioni di Init/Cleanup per la Suite ===
 int init_suite_buffer(void)
@@ -98,6 +99,21 @@ void *multiple_consumer_thread_blocking(void *arg)
     return NULL;
 }
 
+// Continuazione delle operazioni asincrone: salva il messaggio ricevuto
+void async_callback(msg_t *msg, void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    data->msg_retrieved = msg;
+    data->success_count++;
+}
+
+// Esecutore di prova: conta le continuazioni ricevute e le esegue subito
+void counting_executor(void *executor_arg, buffer_callback_t callback, msg_t *msg, void *arg)
+{
+    (*(int *)executor_arg)++;
+    callback(msg, arg);
+}
+
 // === Test Case ===
 
 // • (P=1; C=0; N=1) Produzione di un solo messaggio in un buffer vuoto
@@ -651,6 +667,184 @@ void test_Pgt1_Cgt1_Ngt1_stress_general(void)
     buffer_destroy(buffer);
 }
 
+// Consumazione asincrona da un buffer vuoto, sbloccata da un produttore bloccante
+void test_async_get_resumed_by_blocking_put(void)
+{
+    thread_data_t data;
+    buffer_t *buffer = buffer_init(1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    data.msg_retrieved = NULL;
+    data.success_count = 0;
+
+    get_asincrona(buffer, async_callback, &data); // Il buffer è vuoto: la get resta sospesa
+    CU_ASSERT_EQUAL(data.success_count, 0);
+    CU_ASSERT_PTR_NOT_NULL(buffer->get_waiters);
+
+    msg_t *msg = msg_init_string("ASYNC_GET");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_PTR_EQUAL(put_bloccante(buffer, msg), msg);
+
+    // La continuazione è stata eseguita in linea dal produttore
+    CU_ASSERT_EQUAL(data.success_count, 1);
+    CU_ASSERT_PTR_EQUAL(data.msg_retrieved, msg);
+    CU_ASSERT_EQUAL(buffer->current_size, 0);
+    CU_ASSERT_PTR_NULL(buffer->get_waiters);
+
+    msg_destroy_string(msg);
+    buffer_destroy(buffer);
+}
+
+// Produzione asincrona in un buffer pieno, sbloccata da un consumatore bloccante tramite esecutore
+void test_async_put_resumed_by_blocking_get(void)
+{
+    thread_data_t data;
+    int executed = 0;
+    buffer_t *buffer = buffer_init(1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    buffer_set_executor(buffer, counting_executor, &executed);
+    data.msg_retrieved = NULL;
+    data.success_count = 0;
+
+    msg_t *first = msg_init_string("FIRST");
+    msg_t *second = msg_init_string("SECOND");
+    CU_ASSERT_PTR_EQUAL(put_asincrona(buffer, first, async_callback, &data), first); // Completata subito
+    CU_ASSERT_EQUAL(data.success_count, 1);
+    CU_ASSERT_PTR_EQUAL(put_asincrona(buffer, second, async_callback, &data), second); // Il buffer è pieno
+    CU_ASSERT_EQUAL(data.success_count, 1);
+    CU_ASSERT_EQUAL(buffer->current_size, 1);
+
+    msg_t *retrieved = get_bloccante(buffer); // Libera il posto per la put sospesa
+    CU_ASSERT_PTR_EQUAL(retrieved, first);
+    CU_ASSERT_EQUAL(data.success_count, 2);
+    CU_ASSERT_PTR_EQUAL(data.msg_retrieved, second);
+    CU_ASSERT_EQUAL(executed, 2);
+    CU_ASSERT_EQUAL(buffer->current_size, 1);
+    CU_ASSERT_PTR_EQUAL(buffer->messages[0], second);
+
+    msg_destroy_string(retrieved);
+    buffer_destroy(buffer); // Distruggerà second
+}
+
+// Stato di una consumazione asincrona che si rilancia dalla propria continuazione
+typedef struct
+{
+    buffer_t *buffer;
+    int remaining;
+    int depth;
+    int max_depth;
+} rearm_data_t;
+
+// Continuazione che distrugge il messaggio e rilancia la get asincrona
+void rearm_callback(msg_t *msg, void *arg)
+{
+    rearm_data_t *data = (rearm_data_t *)arg;
+    data->depth++;
+    if (data->depth > data->max_depth)
+    {
+        data->max_depth = data->depth;
+    }
+    msg_destroy_string(msg);
+    if (--data->remaining > 0)
+    {
+        get_asincrona(data->buffer, rearm_callback, data); // Messaggio disponibile: completata subito
+    }
+    data->depth--;
+}
+
+// Una continuazione che rilancia la get asincrona non annida le chiamate
+void test_async_get_rearmed_without_recursion(void)
+{
+    const int NUM_MSGS = 200000;
+    rearm_data_t data;
+    buffer_t *buffer = buffer_init(NUM_MSGS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        put_non_bloccante(buffer, msg_init_string("REARM"));
+    }
+
+    data.buffer = buffer;
+    data.remaining = NUM_MSGS;
+    data.depth = 0;
+    data.max_depth = 0;
+    get_asincrona(buffer, rearm_callback, &data);
+
+    CU_ASSERT_EQUAL(data.remaining, 0);
+    CU_ASSERT_EQUAL(data.max_depth, 1);
+    CU_ASSERT_EQUAL(buffer->current_size, 0);
+
+    buffer_destroy(buffer);
+}
+
+// Le get asincrone sospese ricevono BUFFER_ERROR alla distruzione del buffer
+void test_async_get_completed_on_destroy(void)
+{
+    thread_data_t data;
+    buffer_t *buffer = buffer_init(1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    data.msg_retrieved = msg_init_string("PLACEHOLDER");
+    data.success_count = 0;
+    msg_t *placeholder = data.msg_retrieved;
+
+    get_asincrona(buffer, async_callback, &data);
+    CU_ASSERT_EQUAL(data.success_count, 0);
+
+    buffer_destroy(buffer);
+    CU_ASSERT_EQUAL(data.success_count, 1);
+    CU_ASSERT_PTR_EQUAL(data.msg_retrieved, BUFFER_ERROR);
+
+    msg_destroy_string(placeholder);
+}
+
+// Buffer e messaggi allocati con vincoli NUMA ed huge pages
+void test_numa_hugepage_buffer_and_pool(void)
+{
+    mem_alloc_opts_t opts = {0, false, MEM_HUGEPAGES_TRANSPARENT, NULL};
+    buffer_t *buffer = buffer_init_opts(2, &opts);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    CU_ASSERT_TRUE(buffer->messages_mapped);
+
+    msg_pool_t *pool = msg_pool_init(1, 8, &opts);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+
+    msg_t *pooled = msg_pool_init_string(pool, "POOLED");
+    msg_t *too_long = msg_pool_init_string(pool, "TOO_LONG_FOR_POOL"); // Ricade sullo heap
+    CU_ASSERT_EQUAL(pool->fallbacks, 1);
+    CU_ASSERT_PTR_NULL(pool->free_list); // L'unico blocco è in uso
+
+    put_bloccante(buffer, pooled);
+    put_bloccante(buffer, too_long);
+    msg_t *retrieved = get_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(retrieved->content, "TOO_LONG_FOR_POOL");
+    retrieved->msg_destroy(retrieved);
+
+    buffer_destroy(buffer); // Restituisce pooled al pool
+    CU_ASSERT_PTR_NOT_NULL(pool->free_list);
+    msg_pool_destroy(pool);
+}
+
+// Nodi NUMA non validi: allocazione senza vincoli invece di scrivere fuori dalla maschera
+void test_invalid_numa_node_falls_back(void)
+{
+    int invalid_nodes[] = {-2, -1000, 1024, 1 << 30};
+    unsigned long numa_fallbacks = 0;
+
+    for (unsigned int i = 0; i < sizeof(invalid_nodes) / sizeof(invalid_nodes[0]); i++)
+    {
+        mem_alloc_opts_t opts = {invalid_nodes[i], false, MEM_HUGEPAGES_NONE, &numa_fallbacks};
+        buffer_t *buffer = buffer_init_opts(4, &opts);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+        CU_ASSERT_EQUAL(numa_fallbacks, i + 1); // Segnalato al chiamante, senza stampe
+
+        msg_t *msg = msg_init_string("MSG");
+        CU_ASSERT_PTR_EQUAL(put_non_bloccante(buffer, msg), msg);
+        CU_ASSERT_PTR_EQUAL(get_non_bloccante(buffer), msg);
+        msg_destroy_string(msg);
+        buffer_destroy(buffer);
+    }
+}
+
 // === Main Function per CUnit ===
 int main()
 {
@@ -683,7 +877,13 @@ int main()
         (NULL == CU_add_test(pSuite, "(P>1; C=0; N>1) Produzione concorrente di molteplici messaggi in un buffer vuoto; il buffer si satura in corso", test_Pgt1_C0_Ngt1_concurrent_puts_fill_and_block)) ||
         (NULL == CU_add_test(pSuite, "(P=0; C>1; N>1) Consumazione concorrente di molteplici messaggi da un buffer pieno", test_P0_Cgt1_Ngt1_concurrent_gets_from_full_and_block)) ||
         (NULL == CU_add_test(pSuite, "(P>1; C>1; N=1) Consumazioni e produzioni concorrenti di molteplici messaggi in un buffer unitario", test_Pgt1_Cgt1_N1_stress_unitary)) ||
-        (NULL == CU_add_test(pSuite, "(P>1; C>1; N>1) Consumazioni e produzioni concorrenti di molteplici messaggi in un buffer", test_Pgt1_Cgt1_Ngt1_stress_general)))
+        (NULL == CU_add_test(pSuite, "(P>1; C>1; N>1) Consumazioni e produzioni concorrenti di molteplici messaggi in un buffer", test_Pgt1_Cgt1_Ngt1_stress_general)) ||
+        (NULL == CU_add_test(pSuite, "Consumazione asincrona da un buffer vuoto sbloccata da una produzione bloccante", test_async_get_resumed_by_blocking_put)) ||
+        (NULL == CU_add_test(pSuite, "Produzione asincrona in un buffer pieno sbloccata da una consumazione bloccante", test_async_put_resumed_by_blocking_get)) ||
+        (NULL == CU_add_test(pSuite, "Consumazione asincrona rilanciata dalla continuazione senza ricorsione", test_async_get_rearmed_without_recursion)) ||
+        (NULL == CU_add_test(pSuite, "Consumazione asincrona sospesa completata alla distruzione del buffer", test_async_get_completed_on_destroy)) ||
+        (NULL == CU_add_test(pSuite, "Buffer e messaggi allocati su un nodo NUMA con huge pages", test_numa_hugepage_buffer_and_pool)) ||
+        (NULL == CU_add_test(pSuite, "Nodo NUMA non valido: allocazione senza vincoli", test_invalid_numa_node_falls_back)))
     {
         CU_cleanup_registry();
         return CU_get_error();
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "conflating_buffer.h"
+#include "message.h"
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_conflating_buffer(void)
+{
+    return 0;
+}
+
+int clean_suite_conflating_buffer(void)
+{
+    return 0;
+}
+
+// === Funzioni helper ===
+static int destroyed_count = 0;
+
+// Distruttore che conta i messaggi distrutti
+void counting_destroy(msg_t *msg)
+{
+    destroyed_count++;
+    msg_destroy_string(msg);
+}
+
+// Crea un messaggio stringa con il distruttore che conta
+msg_t *counted_msg(const char *content)
+{
+    msg_t *msg = msg_init_string((void *)content);
+    msg->msg_destroy = counting_destroy;
+    return msg;
+}
+
+typedef struct
+{
+    conflating_buffer_t *buffer;
+    int num_ops;
+} thread_data_t;
+
+// Aggiorna ripetutamente poche chiavi con put bloccanti
+void *updating_producer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    char content[32];
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        sprintf(content, "%d:%d", i % 3, i);
+        put_conflating_bloccante(data->buffer, i % 3, msg_init_string(content));
+    }
+    return NULL;
+}
+
+// === Test Case ===
+
+// Un aggiornamento sostituisce il messaggio in attesa mantenendone la posizione
+void test_replace_keeps_queue_position(void)
+{
+    conflating_buffer_t *buffer = conflating_buffer_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    destroyed_count = 0;
+
+    put_conflating_bloccante(buffer, 1, counted_msg("A1"));
+    put_conflating_bloccante(buffer, 2, counted_msg("B1"));
+    put_conflating_bloccante(buffer, 1, counted_msg("A2")); // Sostituisce A1
+
+    CU_ASSERT_EQUAL(buffer->current_size, 2);
+    CU_ASSERT_EQUAL(destroyed_count, 1);
+    CU_ASSERT_EQUAL(conflating_buffer_conflated(buffer), 1);
+
+    msg_t *first = get_conflating_non_bloccante(buffer);
+    msg_t *second = get_conflating_non_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(first->content, "A2"); // Al posto di A1, prima di B1
+    CU_ASSERT_STRING_EQUAL(second->content, "B1");
+    CU_ASSERT_PTR_EQUAL(get_conflating_non_bloccante(buffer), BUFFER_ERROR);
+
+    // Dopo l'estrazione la chiave torna nuova: niente sostituzione
+    put_conflating_bloccante(buffer, 1, counted_msg("A3"));
+    CU_ASSERT_EQUAL(buffer->current_size, 1);
+    CU_ASSERT_EQUAL(conflating_buffer_conflated(buffer), 1);
+
+    first->msg_destroy(first);
+    second->msg_destroy(second);
+    conflating_buffer_destroy(buffer); // Distruggerà A3
+    CU_ASSERT_EQUAL(destroyed_count, 4);
+}
+
+// Con il buffer pieno gli aggiornamenti di chiavi presenti riescono, le chiavi nuove no
+void test_full_buffer_accepts_updates_only(void)
+{
+    conflating_buffer_t *buffer = conflating_buffer_init(2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    put_conflating_bloccante(buffer, 10, msg_init_string("X1"));
+    put_conflating_bloccante(buffer, 20, msg_init_string("Y1"));
+
+    msg_t *update = msg_init_string("Y2");
+    CU_ASSERT_PTR_EQUAL(put_conflating_non_bloccante(buffer, 20, update), update);
+
+    msg_t *fresh = msg_init_string("Z1");
+    CU_ASSERT_PTR_EQUAL(put_conflating_non_bloccante(buffer, 30, fresh), BUFFER_ERROR);
+    msg_destroy_string(fresh); // Rifiutato: resta nostro
+
+    CU_ASSERT_EQUAL(buffer->current_size, 2);
+    CU_ASSERT_EQUAL(conflating_buffer_conflated(buffer), 1);
+
+    conflating_buffer_destroy(buffer);
+}
+
+// Un produttore veloce su poche chiavi non si blocca mai e l'arretrato resta limitato alle chiavi
+void test_backlog_bounded_by_keys(void)
+{
+    const int NUM_OPS = 3000;
+    pthread_t p_tid;
+    thread_data_t data;
+    conflating_buffer_t *buffer = conflating_buffer_init(3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    data.buffer = buffer;
+    data.num_ops = NUM_OPS;
+    pthread_create(&p_tid, NULL, updating_producer_thread, &data);
+    pthread_join(p_tid, NULL); // Nessun consumatore: terminerebbe solo conflando
+
+    CU_ASSERT_EQUAL(buffer->current_size, 3);
+    CU_ASSERT_EQUAL(conflating_buffer_conflated(buffer), (unsigned long)(NUM_OPS - 3));
+
+    // Resta solo il valore più recente di ogni chiave, nell'ordine di arrivo delle chiavi
+    msg_t *msg = get_conflating_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(msg->content, "0:2997");
+    msg_destroy_string(msg);
+    msg = get_conflating_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(msg->content, "1:2998");
+    msg_destroy_string(msg);
+    msg = get_conflating_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(msg->content, "2:2999");
+    msg_destroy_string(msg);
+
+    conflating_buffer_destroy(buffer);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Conflating_Buffer_Suite", init_suite_conflating_buffer, clean_suite_conflating_buffer);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Sostituzione sul posto del messaggio in attesa", test_replace_keeps_queue_position)) ||
+        (NULL == CU_add_test(pSuite, "Buffer pieno: accettati solo aggiornamenti di chiavi presenti", test_full_buffer_accepts_updates_only)) ||
+        (NULL == CU_add_test(pSuite, "Arretrato limitato dal numero di chiavi", test_backlog_bounded_by_keys)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "durable_queue.h"
+#include "message.h"
+
+static char queue_dir[] = "/tmp/durable_queue_XXXXXX";
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_durable_queue(void)
+{
+    return mkdtemp(queue_dir) == NULL ? -1 : 0;
+}
+
+int clean_suite_durable_queue(void)
+{
+    char path[512];
+    DIR *dir = opendir(queue_dir);
+    struct dirent *entry;
+    while (dir != NULL && (entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] != '.')
+        {
+            snprintf(path, sizeof(path), "%s/%s", queue_dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    if (dir != NULL)
+        closedir(dir);
+    rmdir(queue_dir);
+    return 0;
+}
+
+// === Strutture dati per i thread helper ===
+typedef struct
+{
+    durable_queue_t *queue;
+    int num_ops;
+} thread_data_t;
+
+// === Funzioni helper ===
+void *durable_producer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        put_durable_bloccante(data->queue, msg_init_string("GROUP"));
+    }
+    return NULL;
+}
+
+// Dimensione di un file della coda
+static long file_size(const char *name)
+{
+    char path[256];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", queue_dir, name);
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// Segmenti del log presenti nella directory; in first il nome del primo
+static int count_segments(char *first, size_t size)
+{
+    int count = 0;
+    DIR *dir = opendir(queue_dir);
+    struct dirent *entry;
+    if (first != NULL)
+        first[0] = '\0';
+    while ((entry = readdir(dir)) != NULL)
+    {
+        size_t length = strlen(entry->d_name);
+        if (length > 4 && strcmp(entry->d_name + length - 4, ".log") == 0)
+        {
+            if (first != NULL && (first[0] == '\0' || strcmp(entry->d_name, first) < 0))
+                snprintf(first, size, "%s", entry->d_name);
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+// === Test Case ===
+
+// I messaggi vengono consegnati nell'ordine di inserimento; tutto confermato, i file si svuotano
+void test_put_get_ack_in_order(void)
+{
+    char content[32];
+    uint64_t seq;
+    durable_queue_t *queue = durable_queue_open(queue_dir, 8, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(queue->recovered, 0);
+
+    for (int i = 0; i < 5; i++)
+    {
+        sprintf(content, "DURABLE_%d", i);
+        msg_t *msg = msg_init_string(content);
+        CU_ASSERT_PTR_EQUAL(put_durable_bloccante(queue, msg), msg);
+    }
+    CU_ASSERT_EQUAL(count_segments(NULL, 0), 1);
+
+    for (int i = 0; i < 5; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        sprintf(content, "DURABLE_%d", i);
+        CU_ASSERT_STRING_EQUAL(msg->content, content);
+        CU_ASSERT_EQUAL(seq, (uint64_t)i);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    CU_ASSERT_PTR_EQUAL(get_durable_non_bloccante(queue, &seq), BUFFER_ERROR);
+    CU_ASSERT_EQUAL(queue->ack_floor, 5);
+
+    durable_queue_close(queue);
+    CU_ASSERT_EQUAL(count_segments(NULL, 0), 0);
+    CU_ASSERT_EQUAL(file_size("queue.ack"), 0);
+    CU_ASSERT_EQUAL(file_size("queue.ckpt"), 0);
+}
+
+// Dopo la riapertura vengono riconsegnati, in ordine, solo i messaggi non confermati
+void test_reopen_recovers_unacked(void)
+{
+    const int NUM_MSGS = 200; // Oltre l'intervallo dell'indice sparso
+    char content[32];
+    uint64_t seq;
+    durable_queue_t *queue = durable_queue_open(queue_dir, NUM_MSGS, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        sprintf(content, "RECOVER_%d", i);
+        put_durable_bloccante(queue, msg_init_string(content));
+    }
+
+    // Confermati: i primi 150 ed i pari successivi; consegnati ma non confermati i dispari
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        msg_destroy_string(msg);
+        if (i < 150 || i % 2 == 0)
+        {
+            durable_queue_ack(queue, seq);
+        }
+    }
+    CU_ASSERT_EQUAL(queue->ack_floor, 151);
+    durable_queue_close(queue);
+
+    queue = durable_queue_open(queue_dir, NUM_MSGS, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(queue->recovered, 25);
+    CU_ASSERT_EQUAL(queue->next_seq, (uint64_t)NUM_MSGS);
+
+    for (int i = 151; i < NUM_MSGS; i += 2)
+    {
+        msg_t *msg = get_durable_non_bloccante(queue, &seq);
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(msg, BUFFER_ERROR);
+        sprintf(content, "RECOVER_%d", i);
+        CU_ASSERT_STRING_EQUAL(msg->content, content);
+        CU_ASSERT_EQUAL(seq, (uint64_t)i);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    CU_ASSERT_PTR_EQUAL(get_durable_non_bloccante(queue, &seq), BUFFER_ERROR);
+
+    // I nuovi messaggi proseguono la sequenza
+    put_durable_bloccante(queue, msg_init_string("AFTER"));
+    msg_t *msg = get_durable_bloccante(queue, &seq);
+    CU_ASSERT_STRING_EQUAL(msg->content, "AFTER");
+    CU_ASSERT_EQUAL(seq, (uint64_t)NUM_MSGS);
+    msg_destroy_string(msg);
+    durable_queue_ack(queue, seq);
+
+    durable_queue_close(queue);
+}
+
+// Produttori concorrenti condividono lo stesso fsync
+void test_group_commit(void)
+{
+    const int NUM_PRODUCERS = 8;
+    const int NUM_OPS = 20;
+    pthread_t tids[NUM_PRODUCERS];
+    thread_data_t data;
+    uint64_t seq;
+    durable_queue_t *queue = durable_queue_open(queue_dir, NUM_PRODUCERS * NUM_OPS, 1 << 20, 16, 2000, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+
+    data.queue = queue;
+    data.num_ops = NUM_OPS;
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_create(&tids[i], NULL, durable_producer_thread, &data);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+
+    // Ogni put ritorna dopo il commit, ma i commit sono meno dei messaggi
+    CU_ASSERT_EQUAL(queue->durable_seq, (uint64_t)(NUM_PRODUCERS * NUM_OPS));
+    CU_ASSERT(queue->commits < (unsigned long)(NUM_PRODUCERS * NUM_OPS));
+
+    for (int i = 0; i < NUM_PRODUCERS * NUM_OPS; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    durable_queue_close(queue);
+}
+
+// Un record interrotto da un crash viene scartato all'apertura
+void test_torn_tail_truncated(void)
+{
+    durable_queue_t *queue = durable_queue_open(queue_dir, 8, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    put_durable_bloccante(queue, msg_init_string("KEEP_0"));
+    put_durable_bloccante(queue, msg_init_string("KEEP_1"));
+    durable_queue_close(queue); // Non consegnati: restano sul disco
+
+    char segment[64];
+    CU_ASSERT_EQUAL_FATAL(count_segments(segment, sizeof(segment)), 1);
+    long size = file_size(segment);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", queue_dir, segment);
+    int fd = open(path, O_WRONLY | O_APPEND);
+    CU_ASSERT_FATAL(fd >= 0);
+    CU_ASSERT_EQUAL(write(fd, "\x02\0\0\0\0\0\0\0\x40\0\0\0TORN", 16), 16);
+    close(fd);
+
+    queue = durable_queue_open(queue_dir, 8, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(queue->recovered, 2);
+    CU_ASSERT_EQUAL(queue->next_seq, 2);
+    CU_ASSERT_EQUAL(file_size(segment), size);
+
+    uint64_t seq;
+    for (int i = 0; i < 2; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        CU_ASSERT_NSTRING_EQUAL(msg->content, "KEEP_", 5);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    durable_queue_close(queue);
+}
+
+// Un indice sopravvissuto al troncamento del log non deve far perdere i nuovi record
+void test_stale_index_ignored(void)
+{
+    const int NUM_MSGS = 130; // Voci dell'indice per le sequenze 0, 64 e 128
+    char content[16];
+    uint64_t seq;
+
+    durable_queue_t *queue = durable_queue_open(queue_dir, 2 * NUM_MSGS, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        sprintf(content, "OLD_%03d", i);
+        put_durable_bloccante(queue, msg_init_string(content));
+    }
+    for (int i = 0; i < NUM_MSGS - 1; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    durable_queue_close(queue); // L'ultimo non è consegnato: i file restano
+
+    // Log del segmento troncato, indice rimasto
+    char segment[64], path[256];
+    CU_ASSERT_EQUAL_FATAL(count_segments(segment, sizeof(segment)), 1);
+    snprintf(path, sizeof(path), "%s/%s", queue_dir, segment);
+    CU_ASSERT_EQUAL(truncate(path, 0), 0);
+
+    // Record nuovi, della stessa lunghezza, oltre l'offset della vecchia voce 128
+    queue = durable_queue_open(queue_dir, 2 * NUM_MSGS, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(queue->next_seq, (uint64_t)(NUM_MSGS - 1));
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        sprintf(content, "NEW_%03d", i);
+        put_durable_bloccante(queue, msg_init_string(content));
+    }
+    durable_queue_close(queue);
+
+    queue = durable_queue_open(queue_dir, 2 * NUM_MSGS, 1 << 20, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(queue->recovered, (unsigned long)NUM_MSGS);
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        sprintf(content, "NEW_%03d", i);
+        CU_ASSERT_STRING_EQUAL(msg->content, content);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    durable_queue_close(queue);
+}
+
+// Segmenti completamente confermati rimossi, conferme compattate e ripristino su più segmenti
+void test_segments_reclaimed_and_recovered(void)
+{
+    const int NUM_MSGS = 1000;
+    const int NUM_UNACKED = 20;
+    char content[32];
+    uint64_t seq;
+
+    // 32 byte per record: circa 8 record per segmento
+    durable_queue_t *queue = durable_queue_open(queue_dir, 64, 256, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        sprintf(content, "SEG_%04d", i);
+        put_durable_bloccante(queue, msg_init_string(content));
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+
+    // Lo spazio su disco non cresce con i messaggi confermati
+    CU_ASSERT(queue->reclaimed >= (unsigned long)(NUM_MSGS / 8 - 2));
+    CU_ASSERT(count_segments(NULL, 0) <= 2);
+    CU_ASSERT(file_size("queue.ack") <= (long)(2 * 64 * sizeof(uint64_t)));
+    CU_ASSERT_EQUAL(file_size("queue.ckpt"), 32);
+
+    // Confermati solo i primi 5 ed i pari: gli altri vanno ripristinati da più segmenti
+    for (int i = 0; i < NUM_UNACKED; i++)
+    {
+        sprintf(content, "SEG_%04d", NUM_MSGS + i);
+        put_durable_bloccante(queue, msg_init_string(content));
+    }
+    for (int i = 0; i < NUM_UNACKED; i++)
+    {
+        msg_t *msg = get_durable_bloccante(queue, &seq);
+        msg_destroy_string(msg);
+        if (i < 5 || i % 2 == 0)
+        {
+            durable_queue_ack(queue, seq);
+        }
+    }
+    durable_queue_close(queue);
+    CU_ASSERT(count_segments(NULL, 0) >= 2);
+
+    queue = durable_queue_open(queue_dir, 64, 256, 1, 0, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(queue->ack_floor, (uint64_t)(NUM_MSGS + 5));
+    CU_ASSERT_EQUAL(queue->next_seq, (uint64_t)(NUM_MSGS + NUM_UNACKED));
+    CU_ASSERT_EQUAL(queue->recovered, 8); // I dispari da 5 a 19
+    for (int i = 5; i < NUM_UNACKED; i += 2)
+    {
+        msg_t *msg = get_durable_non_bloccante(queue, &seq);
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(msg, BUFFER_ERROR);
+        sprintf(content, "SEG_%04d", NUM_MSGS + i);
+        CU_ASSERT_STRING_EQUAL(msg->content, content);
+        msg_destroy_string(msg);
+        durable_queue_ack(queue, seq);
+    }
+    CU_ASSERT_PTR_EQUAL(get_durable_non_bloccante(queue, &seq), BUFFER_ERROR);
+
+    durable_queue_close(queue);
+    CU_ASSERT_EQUAL(count_segments(NULL, 0), 0);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Durable_Queue_Suite", init_suite_durable_queue, clean_suite_durable_queue);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Consegna nell'ordine di inserimento e conferma", test_put_get_ack_in_order)) ||
+        (NULL == CU_add_test(pSuite, "Ripristino dei messaggi non confermati", test_reopen_recovers_unacked)) ||
+        (NULL == CU_add_test(pSuite, "Commit di gruppo con produttori concorrenti", test_group_commit)) ||
+        (NULL == CU_add_test(pSuite, "Record incompleto in coda al log", test_torn_tail_truncated)) ||
+        (NULL == CU_add_test(pSuite, "Indice non coerente con il log ignorato", test_stale_index_ignored)) ||
+        (NULL == CU_add_test(pSuite, "Segmenti confermati rimossi e ripristino su più segmenti", test_segments_reclaimed_and_recovered)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "executor.h"
+#include "message.h"
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_executor(void)
+{
+    return 0;
+}
+
+int clean_suite_executor(void)
+{
+    return 0;
+}
+
+// === Strutture dati per i task helper ===
+typedef struct
+{
+    executor_t *executor;
+    atomic_int executed; // Task eseguiti
+    int fanout;          // Sotto-task generati da ogni task "SPAWN"
+    atomic_bool release; // Sblocca i task "BLOCK"
+} task_data_t;
+
+typedef struct
+{
+    executor_t *executor;
+    msg_t *msg;
+    msg_t *result;
+} submit_args_t;
+
+// === Funzioni helper per i task ===
+void counting_task(msg_t *msg, void *arg)
+{
+    task_data_t *data = (task_data_t *)arg;
+
+    // Un task "SPAWN" genera fanout sotto-task dall'interno del worker
+    if (strcmp((char *)msg->content, "SPAWN") == 0 || strcmp((char *)msg->content, "SPAWN_WAIT") == 0)
+    {
+        for (int i = 0; i < data->fanout; i++)
+        {
+            executor_submit(data->executor, msg_init_string("CHILD"));
+        }
+    }
+
+    // "SPAWN_WAIT" tiene occupato il worker finché gli altri non eseguono
+    // qualche sotto-task, che possono ottenere solo rubandolo (max 5 s)
+    if (strcmp((char *)msg->content, "SPAWN_WAIT") == 0)
+    {
+        for (int i = 0; i < 5000 && atomic_load(&data->executed) == 0; i++)
+        {
+            usleep(1000);
+        }
+    }
+
+    // "BLOCK" tiene occupato il worker fino al via libera del test
+    if (strcmp((char *)msg->content, "BLOCK") == 0)
+    {
+        while (!atomic_load(&data->release))
+        {
+            usleep(1000);
+        }
+    }
+
+    atomic_fetch_add(&data->executed, 1);
+    msg_destroy_string(msg); // Il task è responsabile del messaggio
+}
+
+void *submit_thread(void *arg)
+{
+    submit_args_t *args = (submit_args_t *)arg;
+    args->result = executor_submit(args->executor, args->msg);
+    return NULL;
+}
+
+void *shutdown_thread(void *arg)
+{
+    executor_shutdown((executor_t *)arg);
+    return NULL;
+}
+
+// === Test Case ===
+
+// Tutti i task sottomessi dall'esterno vengono eseguiti esattamente una volta
+void test_external_submit_all_executed(void)
+{
+    const int NUM_TASKS = 1000;
+    task_data_t data;
+    atomic_init(&data.executed, 0);
+    data.fanout = 0;
+    atomic_init(&data.release, false);
+
+    executor_t *executor = executor_init(4, 64, 8, counting_task, &data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(executor);
+    data.executor = executor;
+
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        msg_t *msg = msg_init_string("TASK");
+        CU_ASSERT_PTR_EQUAL(executor_submit(executor, msg), msg);
+    }
+
+    executor_shutdown(executor);
+
+    executor_stats_t stats;
+    executor_stats(executor, &stats);
+    CU_ASSERT_EQUAL(atomic_load(&data.executed), NUM_TASKS);
+    CU_ASSERT_EQUAL(stats.submitted, (unsigned long)NUM_TASKS);
+    CU_ASSERT_EQUAL(stats.executed, (unsigned long)NUM_TASKS);
+    CU_ASSERT_EQUAL(stats.local + stats.injected + stats.stolen, (unsigned long)NUM_TASKS);
+
+    executor_destroy(executor);
+}
+
+// I sotto-task generati dai worker finiscono nelle deque locali e vengono rubati dagli altri
+void test_internal_submit_local_and_stolen(void)
+{
+    const int NUM_SPAWN = 20;
+    const int FANOUT = 50;
+    task_data_t data;
+    atomic_init(&data.executed, 0);
+    data.fanout = FANOUT;
+    atomic_init(&data.release, false);
+
+    executor_t *executor = executor_init(4, 64, 4, counting_task, &data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(executor);
+    data.executor = executor;
+
+    // Squilibrio forzato: i sotto-task del primo restano nella deque di un worker occupato
+    executor_submit(executor, msg_init_string("SPAWN_WAIT"));
+    for (int i = 1; i < NUM_SPAWN; i++)
+    {
+        executor_submit(executor, msg_init_string("SPAWN"));
+    }
+
+    executor_shutdown(executor); // Deve attendere anche i sotto-task
+
+    executor_stats_t stats;
+    executor_stats(executor, &stats);
+    CU_ASSERT_EQUAL(atomic_load(&data.executed), NUM_SPAWN * (FANOUT + 1));
+    CU_ASSERT_EQUAL(stats.submitted, (unsigned long)(NUM_SPAWN * (FANOUT + 1)));
+    CU_ASSERT_EQUAL(stats.executed, stats.submitted);
+    CU_ASSERT(stats.local > 0);
+    CU_ASSERT(stats.stolen > 0);
+
+    executor_destroy(executor);
+}
+
+// Worker inattivi si sospendono e dopo la chiusura i task esterni vengono rifiutati
+void test_idle_park_and_reject_after_shutdown(void)
+{
+    task_data_t data;
+    atomic_init(&data.executed, 0);
+    data.fanout = 0;
+    atomic_init(&data.release, false);
+
+    executor_t *executor = executor_init(2, 8, 8, counting_task, &data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(executor);
+    data.executor = executor;
+
+    sleep(1); // Nessun lavoro: i worker devono sospendersi invece di girare a vuoto
+
+    executor_stats_t stats;
+    executor_stats(executor, &stats);
+    CU_ASSERT_EQUAL(atomic_load(&executor->parked), 2);
+    CU_ASSERT(stats.parks >= 2);
+
+    executor_shutdown(executor);
+
+    msg_t *late = msg_init_string("LATE");
+    CU_ASSERT_PTR_EQUAL(executor_submit(executor, late), BUFFER_ERROR);
+    msg_destroy_string(late); // Rifiutato: resta nostro
+
+    CU_ASSERT_EQUAL(atomic_load(&data.executed), 0);
+    executor_destroy(executor);
+}
+
+// Una sottomissione sospesa sulla coda di iniezione piena viene rifiutata dalla chiusura
+void test_blocked_submit_rejected_by_shutdown(void)
+{
+    task_data_t data;
+    atomic_init(&data.executed, 0);
+    data.fanout = 0;
+    atomic_init(&data.release, false);
+
+    executor_t *executor = executor_init(1, 8, 1, counting_task, &data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(executor);
+    data.executor = executor;
+
+    // L'unico worker resta su BLOCK e TASK riempie la coda di iniezione
+    msg_t *block = msg_init_string("BLOCK");
+    CU_ASSERT_PTR_EQUAL(executor_submit(executor, block), block);
+    msg_t *task = msg_init_string("TASK");
+    CU_ASSERT_PTR_EQUAL(executor_submit(executor, task), task);
+
+    submit_args_t args = {executor, msg_init_string("LATE"), NULL};
+    pthread_t submitter, closer;
+    pthread_create(&submitter, NULL, submit_thread, &args);
+    usleep(100000); // Il produttore si sospende sulla coda piena
+
+    pthread_create(&closer, NULL, shutdown_thread, executor);
+    pthread_join(submitter, NULL); // Deve risvegliarsi con il worker ancora occupato
+    CU_ASSERT_PTR_EQUAL(args.result, BUFFER_ERROR);
+    msg_destroy_string(args.msg); // Rifiutato: resta nostro
+
+    atomic_store(&data.release, true);
+    pthread_join(closer, NULL);
+
+    // I task accettati prima della chiusura vengono comunque eseguiti
+    CU_ASSERT_EQUAL(atomic_load(&data.executed), 2);
+    executor_destroy(executor);
+}
+
+// Senza worker i task accettati vengono eseguiti da executor_shutdown
+void test_shutdown_drains_without_workers(void)
+{
+    const int NUM_TASKS = 4;
+    task_data_t data;
+    atomic_init(&data.executed, 0);
+    data.fanout = 0;
+    atomic_init(&data.release, false);
+
+    executor_t *executor = executor_init(0, 8, NUM_TASKS, counting_task, &data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(executor);
+    data.executor = executor;
+
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        msg_t *msg = msg_init_string("TASK");
+        CU_ASSERT_PTR_EQUAL(executor_submit(executor, msg), msg);
+    }
+    CU_ASSERT_EQUAL(atomic_load(&data.executed), 0);
+
+    executor_shutdown(executor);
+    executor_shutdown(executor); // Una seconda chiamata non fa nulla
+
+    executor_stats_t stats;
+    executor_stats(executor, &stats);
+    CU_ASSERT_EQUAL(atomic_load(&data.executed), NUM_TASKS);
+    CU_ASSERT_EQUAL(stats.executed, (unsigned long)NUM_TASKS);
+    CU_ASSERT_EQUAL(stats.submitted, (unsigned long)NUM_TASKS);
+
+    executor_destroy(executor);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Executor_Suite", init_suite_executor, clean_suite_executor);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Sottomissione esterna: ogni task eseguito una sola volta", test_external_submit_all_executed)) ||
+        (NULL == CU_add_test(pSuite, "Sottomissione interna: deque locali e work stealing", test_internal_submit_local_and_stolen)) ||
+        (NULL == CU_add_test(pSuite, "Worker inattivi sospesi e rifiuto dopo la chiusura", test_idle_park_and_reject_after_shutdown)) ||
+        (NULL == CU_add_test(pSuite, "Sottomissione sospesa rifiutata dalla chiusura", test_blocked_submit_rejected_by_shutdown)) ||
+        (NULL == CU_add_test(pSuite, "Chiusura senza worker: task eseguiti dal chiamante", test_shutdown_drains_without_workers)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "keyed_buffer.h"
+#include "message.h"
+
+#define NUM_KEYS 8
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_keyed_buffer(void)
+{
+    return 0;
+}
+
+int clean_suite_keyed_buffer(void)
+{
+    return 0;
+}
+
+// === Strutture dati per i thread helper ===
+typedef struct
+{
+    keyed_buffer_t *buffer;
+    int *last_seq;     // Ultima sequenza elaborata per chiave, condivisa tra i consumatori
+    int num_ops;       // Messaggi da elaborare (produttore) o BUFFER_ERROR atteso (consumatore)
+    int success_count; // Messaggi elaborati in ordine
+    int order_errors;  // Messaggi elaborati fuori ordine
+} thread_data_t;
+
+// === Funzioni helper per i thread ===
+
+// Produce num_ops messaggi "chiave:sequenza" distribuiti ciclicamente sulle chiavi
+void *keyed_producer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    char content[32];
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        sprintf(content, "%d:%d", i % NUM_KEYS, i / NUM_KEYS);
+        put_keyed_bloccante(data->buffer, i % NUM_KEYS, msg_init_string(content));
+    }
+    return NULL;
+}
+
+// Consuma finché non viene deregistrato, verificando l'ordine per chiave
+void *keyed_consumer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    int consumer = keyed_buffer_join(data->buffer);
+    data->success_count = 0;
+    data->order_errors = 0;
+
+    msg_t *msg;
+    while (data->success_count + data->order_errors < data->num_ops &&
+           (msg = get_keyed_bloccante(data->buffer, consumer)) != BUFFER_ERROR)
+    {
+        int key, seq;
+        sscanf((char *)msg->content, "%d:%d", &key, &seq);
+
+        // La chiave è elaborata da un solo consumatore alla volta: nessun lock sul contatore
+        if (seq == data->last_seq[key] + 1)
+        {
+            data->success_count++;
+        }
+        else
+        {
+            data->order_errors++;
+        }
+        usleep(100);
+        data->last_seq[key] = seq;
+        msg_destroy_string(msg);
+    }
+
+    keyed_buffer_leave(data->buffer, consumer);
+    return NULL;
+}
+
+// Conta le partizioni assegnate ad un consumatore
+int owned_partitions(keyed_buffer_t *buffer, int consumer)
+{
+    int owned = 0;
+    for (unsigned int p = 0; p < buffer->num_partitions; p++)
+    {
+        if (buffer->partitions[p].owner == consumer)
+        {
+            owned++;
+        }
+    }
+    return owned;
+}
+
+// === Test Case ===
+
+// Più consumatori in parallelo: ogni chiave viene elaborata in ordine
+void test_per_key_order_with_parallel_consumers(void)
+{
+    const int NUM_CONSUMERS = 4;
+    const int NUM_MSGS = 800;
+    int last_seq[NUM_KEYS];
+    pthread_t p_tid, c_tids[NUM_CONSUMERS];
+    thread_data_t p_data, c_data[NUM_CONSUMERS];
+
+    keyed_buffer_t *buffer = keyed_buffer_init(16, 16, NUM_CONSUMERS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    for (int k = 0; k < NUM_KEYS; k++)
+    {
+        last_seq[k] = -1;
+    }
+
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        c_data[i].buffer = buffer;
+        c_data[i].last_seq = last_seq;
+        c_data[i].num_ops = NUM_MSGS; // Ogni consumatore si ferma quando viene deregistrato
+        pthread_create(&c_tids[i], NULL, keyed_consumer_thread, &c_data[i]);
+    }
+
+    p_data.buffer = buffer;
+    p_data.num_ops = NUM_MSGS;
+    pthread_create(&p_tid, NULL, keyed_producer_thread, &p_data);
+    pthread_join(p_tid, NULL);
+
+    // Attende che il buffer si svuoti, poi deregistra i consumatori
+    while (1)
+    {
+        pthread_mutex_lock(&buffer->mutex);
+        unsigned int remaining = buffer->current_size;
+        pthread_mutex_unlock(&buffer->mutex);
+        if (remaining == 0)
+        {
+            break;
+        }
+        usleep(1000);
+    }
+    sleep(1);
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        keyed_buffer_leave(buffer, i);
+    }
+
+    int total = 0, errors = 0;
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        pthread_join(c_tids[i], NULL);
+        total += c_data[i].success_count;
+        errors += c_data[i].order_errors;
+    }
+
+    CU_ASSERT_EQUAL(errors, 0);
+    CU_ASSERT_EQUAL(total, NUM_MSGS);
+    for (int k = 0; k < NUM_KEYS; k++)
+    {
+        CU_ASSERT_EQUAL(last_seq[k], NUM_MSGS / NUM_KEYS - 1);
+    }
+
+    keyed_buffer_destroy(buffer);
+}
+
+// Le partizioni vengono ridistribuite quando i consumatori entrano ed escono
+void test_rebalance_on_join_and_leave(void)
+{
+    keyed_buffer_t *buffer = keyed_buffer_init(4, 6, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    int c0 = keyed_buffer_join(buffer);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c0), 6);
+
+    int c1 = keyed_buffer_join(buffer);
+    int c2 = keyed_buffer_join(buffer);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c0), 2);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c1), 2);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c2), 2);
+    CU_ASSERT_EQUAL(keyed_buffer_join(buffer), KEYED_NO_CONSUMER); // Limite raggiunto
+
+    keyed_buffer_leave(buffer, c1);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c0), 3);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c1), 0);
+    CU_ASSERT_EQUAL(owned_partitions(buffer, c2), 3);
+    CU_ASSERT_PTR_EQUAL(get_keyed_non_bloccante(buffer, c1), BUFFER_ERROR); // Non più registrato
+
+    keyed_buffer_destroy(buffer);
+}
+
+// Una partizione passata ad un altro consumatore resta al precedente finché non conclude
+void test_busy_partition_waits_for_previous_owner(void)
+{
+    keyed_buffer_t *buffer = keyed_buffer_init(4, 1, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    int c0 = keyed_buffer_join(buffer);
+    put_keyed_bloccante(buffer, 42, msg_init_string("FIRST"));
+    put_keyed_bloccante(buffer, 42, msg_init_string("SECOND"));
+
+    msg_t *first = get_keyed_non_bloccante(buffer, c0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+    CU_ASSERT_STRING_EQUAL(first->content, "FIRST");
+
+    // c1 entra mentre c0 elabora FIRST, poi c0 esce lasciando la partizione a c1
+    int c1 = keyed_buffer_join(buffer);
+    keyed_buffer_leave(buffer, c0); // Conclude FIRST: ora SECOND è disponibile per c1
+    msg_t *second = get_keyed_non_bloccante(buffer, c1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(second);
+    CU_ASSERT_STRING_EQUAL(second->content, "SECOND");
+    msg_destroy_string(first);
+    msg_destroy_string(second);
+
+    // Con una sola partizione, finché c1 non conclude nessun altro riceve la chiave
+    int c2 = keyed_buffer_join(buffer);
+    put_keyed_bloccante(buffer, 42, msg_init_string("THIRD"));
+    CU_ASSERT_EQUAL(buffer->partitions[0].owner, c2);
+    CU_ASSERT_PTR_EQUAL(get_keyed_non_bloccante(buffer, c2), BUFFER_ERROR); // Occupata da c1
+    keyed_buffer_done(buffer, c1);
+    msg_t *third = get_keyed_non_bloccante(buffer, c2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(third);
+    CU_ASSERT_STRING_EQUAL(third->content, "THIRD");
+    msg_destroy_string(third);
+
+    keyed_buffer_destroy(buffer);
+}
+
+// Identificativi fuori limite o non registrati vengono rifiutati
+void test_invalid_consumer_rejected(void)
+{
+    keyed_buffer_t *buffer = keyed_buffer_init(4, 2, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    put_keyed_bloccante(buffer, 7, msg_init_string("KEPT"));
+
+    // Nessun consumatore registrato: slot valido ma libero
+    CU_ASSERT_PTR_EQUAL(get_keyed_non_bloccante(buffer, 0), BUFFER_ERROR);
+    CU_ASSERT_PTR_EQUAL(get_keyed_bloccante(buffer, 1), BUFFER_ERROR); // Non deve sospendersi
+
+    // Fuori da [0, max_consumers)
+    CU_ASSERT_PTR_EQUAL(get_keyed_non_bloccante(buffer, -1), BUFFER_ERROR);
+    CU_ASSERT_PTR_EQUAL(get_keyed_non_bloccante(buffer, 2), BUFFER_ERROR);
+    CU_ASSERT_PTR_EQUAL(get_keyed_bloccante(buffer, KEYED_NO_CONSUMER), BUFFER_ERROR);
+    CU_ASSERT_PTR_EQUAL(get_keyed_bloccante(buffer, 1000), BUFFER_ERROR);
+    keyed_buffer_done(buffer, -5);
+    keyed_buffer_done(buffer, 2);
+    keyed_buffer_leave(buffer, -1);
+    keyed_buffer_leave(buffer, 2);
+    keyed_buffer_leave(buffer, 1);
+
+    // Il buffer resta coerente: un consumatore registrato riceve il messaggio
+    int c0 = keyed_buffer_join(buffer);
+    CU_ASSERT_EQUAL(buffer->num_consumers, 1);
+    msg_t *msg = get_keyed_non_bloccante(buffer, c0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_STRING_EQUAL(msg->content, "KEPT");
+    msg_destroy_string(msg);
+
+    keyed_buffer_destroy(buffer);
+}
+
+// Get sospesa su un consumatore uscito
+void *blocked_getter_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    msg_t *msg = get_keyed_bloccante(data->buffer, 0);
+    data->success_count = msg == BUFFER_ERROR ? 0 : 1;
+    if (msg != BUFFER_ERROR)
+    {
+        msg_destroy_string(msg);
+    }
+    return NULL;
+}
+
+// Una get sospesa di un consumatore uscito non serve chi riusa il suo identificativo
+void test_reused_id_does_not_wake_old_getter(void)
+{
+    keyed_buffer_t *buffer = keyed_buffer_init(4, 2, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    CU_ASSERT_EQUAL(keyed_buffer_join(buffer), 0);
+
+    thread_data_t data = {buffer, NULL, 0, -1, 0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, blocked_getter_thread, &data);
+    sleep(1); // La get si sospende
+
+    // Uscita e nuovo ingresso prima che la get sospesa si risvegli
+    keyed_buffer_leave(buffer, 0);
+    CU_ASSERT_EQUAL(keyed_buffer_join(buffer), 0);
+    put_keyed_bloccante(buffer, 3, msg_init_string("NEW"));
+
+    pthread_join(tid, NULL);
+    CU_ASSERT_EQUAL(data.success_count, 0);
+
+    msg_t *msg = get_keyed_non_bloccante(buffer, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_STRING_EQUAL(msg->content, "NEW");
+    msg_destroy_string(msg);
+
+    keyed_buffer_destroy(buffer);
+}
+
+// Code delle partizioni piccole all'inizio, espanse mantenendo l'ordine
+void test_partition_ring_grows_in_order(void)
+{
+    const unsigned int MAX_SIZE = 100;
+    keyed_buffer_t *buffer = keyed_buffer_init(MAX_SIZE, 4, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    CU_ASSERT_EQUAL(buffer->partitions[0].capacity, KEYED_PARTITION_MIN_CAPACITY);
+
+    int consumer = keyed_buffer_join(buffer);
+    char content[32];
+
+    // Testa spostata in avanti, poi tutto il buffer su una sola chiave
+    for (int i = 0; i < 5; i++)
+    {
+        put_keyed_bloccante(buffer, 1, msg_init_string("SKIP"));
+        msg_destroy_string(get_keyed_non_bloccante(buffer, consumer));
+    }
+    for (unsigned int i = 0; i < MAX_SIZE; i++)
+    {
+        sprintf(content, "%u", i);
+        CU_ASSERT_PTR_NOT_EQUAL(put_keyed_non_bloccante(buffer, 1, msg_init_string(content)), BUFFER_ERROR);
+    }
+    msg_t *rejected = msg_init_string("FULL");
+    CU_ASSERT_PTR_EQUAL(put_keyed_non_bloccante(buffer, 1, rejected), BUFFER_ERROR);
+    msg_destroy_string(rejected);
+
+    unsigned int in_order = 0;
+    msg_t *msg;
+    while ((msg = get_keyed_non_bloccante(buffer, consumer)) != BUFFER_ERROR)
+    {
+        sprintf(content, "%u", in_order);
+        in_order += strcmp(msg->content, content) == 0;
+        msg_destroy_string(msg);
+    }
+    CU_ASSERT_EQUAL(in_order, MAX_SIZE);
+
+    // Nessuna coda oltre max_size, le altre partizioni restano piccole
+    unsigned int grown = 0;
+    for (unsigned int p = 0; p < buffer->num_partitions; p++)
+    {
+        CU_ASSERT(buffer->partitions[p].capacity <= MAX_SIZE);
+        grown += buffer->partitions[p].capacity > KEYED_PARTITION_MIN_CAPACITY;
+    }
+    CU_ASSERT_EQUAL(grown, 1);
+
+    keyed_buffer_destroy(buffer);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Keyed_Buffer_Suite", init_suite_keyed_buffer, clean_suite_keyed_buffer);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Consumatori paralleli: ordine preservato per chiave", test_per_key_order_with_parallel_consumers)) ||
+        (NULL == CU_add_test(pSuite, "Ribilanciamento delle partizioni all'ingresso e all'uscita dei consumatori", test_rebalance_on_join_and_leave)) ||
+        (NULL == CU_add_test(pSuite, "Partizione occupata trattenuta dal consumatore precedente", test_busy_partition_waits_for_previous_owner)) ||
+        (NULL == CU_add_test(pSuite, "Consumatori non validi o non registrati rifiutati", test_invalid_consumer_rejected)) ||
+        (NULL == CU_add_test(pSuite, "Identificativo riassegnato: la get sospesa del consumatore uscito fallisce", test_reused_id_does_not_wake_old_getter)) ||
+        (NULL == CU_add_test(pSuite, "Code delle partizioni espanse su richiesta in ordine", test_partition_ring_grows_in_order)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "buffer.h"
+#include "message.h"
+#include "msg_batch.h"
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_msg_batch(void)
+{
+    return 0;
+}
+
+int clean_suite_msg_batch(void)
+{
+    return 0;
+}
+
+// === Strutture dati per i thread helper ===
+typedef struct
+{
+    buffer_t *buffer;
+    int num_ops;
+} thread_data_t;
+
+// === Funzioni helper per i thread ===
+void *batch_consumer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        msg_t *msg = get_bloccante(data->buffer);
+        msg->msg_destroy(msg); // L'ultimo dealloca il lotto
+    }
+    return NULL;
+}
+
+// Scrive in packed NUM stringhe di lunghezza variabile; restituisce i byte scritti
+static size_t pack_strings(char *packed, int num)
+{
+    size_t length = 0;
+    for (int i = 0; i < num; i++)
+    {
+        // Lunghezze da 0 a 36: i \0 cadono in ogni posizione dei blocchi da 16 byte
+        int repeat = i % 37;
+        for (int j = 0; j < repeat; j++)
+        {
+            packed[length++] = (char)('a' + (i + j) % 26);
+        }
+        packed[length++] = '\0';
+    }
+    return length;
+}
+
+// === Test Case ===
+
+// Ogni stringa del blocco diventa un messaggio, nell'ordine
+void test_packed_strings_split(void)
+{
+    const int NUM_STRINGS = 1000;
+    char *packed = (char *)malloc(NUM_STRINGS * 40);
+    size_t length = pack_strings(packed, NUM_STRINGS);
+
+    msg_batch_t *batch = msg_batch_init_strings(packed, length);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(batch);
+    CU_ASSERT_EQUAL_FATAL(batch->count, (unsigned int)NUM_STRINGS);
+
+    const char *expected = packed;
+    for (int i = 0; i < NUM_STRINGS; i++)
+    {
+        msg_t *msg = msg_batch_msg(batch, (unsigned int)i);
+        CU_ASSERT_STRING_EQUAL(msg->content, expected);
+        CU_ASSERT_PTR_NOT_EQUAL(msg->content, expected); // Copia privata
+        expected += strlen(expected) + 1;
+    }
+
+    msg_batch_release(batch);
+    free(packed);
+}
+
+// Una stringa finale senza \0 è comunque un messaggio; un blocco vuoto non ne ha
+void test_unterminated_and_empty(void)
+{
+    const char packed[] = {'O', 'N', 'E', '\0', '\0', 'T', 'W', 'O'};
+    msg_batch_t *batch = msg_batch_init_strings(packed, sizeof(packed));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(batch);
+    CU_ASSERT_EQUAL_FATAL(batch->count, 3);
+    CU_ASSERT_STRING_EQUAL(msg_batch_msg(batch, 0)->content, "ONE");
+    CU_ASSERT_STRING_EQUAL(msg_batch_msg(batch, 1)->content, "");
+    CU_ASSERT_STRING_EQUAL(msg_batch_msg(batch, 2)->content, "TWO");
+    msg_batch_release(batch);
+
+    batch = msg_batch_init_strings("", 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(batch);
+    CU_ASSERT_EQUAL(batch->count, 0);
+    msg_batch_detach(batch); // Nessun messaggio: deallocato subito
+}
+
+// Le copie sono messaggi ordinari e sopravvivono al rilascio del lotto
+void test_copy_escapes_and_release(void)
+{
+    const char packed[] = "FIRST\0SECOND\0THIRD";
+    msg_batch_t *batch = msg_batch_init_strings(packed, sizeof(packed));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(batch);
+
+    msg_t *copy = msg_batch_msg(batch, 1)->msg_copy(msg_batch_msg(batch, 1));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(copy);
+    CU_ASSERT_PTR_EQUAL(copy->msg_destroy, msg_destroy_string);
+
+    // Alcuni distrutti singolarmente, gli altri rilasciati in blocco
+    msg_batch_msg(batch, 0)->msg_destroy(msg_batch_msg(batch, 0));
+    msg_batch_release(batch);
+
+    CU_ASSERT_STRING_EQUAL(copy->content, "SECOND");
+    copy->msg_destroy(copy);
+}
+
+// I messaggi attraversano un buffer come gli altri: l'ultimo distrutto dealloca il lotto
+void test_batch_through_buffer(void)
+{
+    const int NUM_STRINGS = 4000;
+    const int NUM_CONSUMERS = 4;
+    const int REMAINING = 8; // Distrutti da buffer_destroy
+    pthread_t tids[NUM_CONSUMERS];
+    thread_data_t data;
+    char *packed = (char *)malloc(NUM_STRINGS * 40);
+    size_t length = pack_strings(packed, NUM_STRINGS);
+
+    msg_batch_t *batch = msg_batch_init_strings(packed, length);
+    free(packed);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(batch);
+
+    buffer_t *buffer = buffer_init(16);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    data.buffer = buffer;
+    data.num_ops = (NUM_STRINGS - REMAINING) / NUM_CONSUMERS;
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        pthread_create(&tids[i], NULL, batch_consumer_thread, &data);
+    }
+
+    for (unsigned int i = 0; i < batch->count; i++)
+    {
+        put_bloccante(buffer, msg_batch_msg(batch, i));
+    }
+    msg_batch_detach(batch); // Da qui il lotto appartiene ai messaggi
+
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+    CU_ASSERT_EQUAL(buffer->current_size, (unsigned int)REMAINING);
+
+    buffer_destroy(buffer); // Distrugge gli ultimi messaggi e con loro il lotto
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Msg_Batch_Suite", init_suite_msg_batch, clean_suite_msg_batch);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Un messaggio per ogni stringa del blocco", test_packed_strings_split)) ||
+        (NULL == CU_add_test(pSuite, "Ultima stringa non terminata e blocco vuoto", test_unterminated_and_empty)) ||
+        (NULL == CU_add_test(pSuite, "Copie fuori dal lotto e rilascio in blocco", test_copy_escapes_and_release)) ||
+        (NULL == CU_add_test(pSuite, "Messaggi del lotto in un buffer", test_batch_through_buffer)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
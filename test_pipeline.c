@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "pipeline.h"
+#include "message.h"
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_pipeline(void)
+{
+    return 0;
+}
+
+int clean_suite_pipeline(void)
+{
+    return 0;
+}
+
+// === Funzioni helper per gli stadi ===
+
+// Aggiunge un carattere (passato in arg) in fondo al contenuto del messaggio
+msg_t *append_stage(msg_t *msg, void *arg)
+{
+    char content[64];
+    snprintf(content, sizeof(content), "%s%c", (char *)msg->content, *(char *)arg);
+    msg_t *out = msg_init_string(content);
+    msg_destroy_string(msg);
+    return out;
+}
+
+// Scarta i messaggi il cui contenuto termina con una cifra dispari
+msg_t *filter_odd_stage(msg_t *msg, void *arg)
+{
+    (void)arg;
+    char *content = (char *)msg->content;
+    if ((content[strlen(content) - 1] - '0') % 2 == 1)
+    {
+        msg_destroy_string(msg);
+        return NULL;
+    }
+    return msg;
+}
+
+// === Strutture dati per i thread helper ===
+typedef struct
+{
+    pipeline_t *pipeline;
+    int num_msgs;
+} producer_data_t;
+
+// Inserisce num_msgs messaggi "0".."9" ciclici e chiude la pipeline
+void *producer_thread(void *arg)
+{
+    producer_data_t *data = (producer_data_t *)arg;
+    char content[16];
+    for (int i = 0; i < data->num_msgs; i++)
+    {
+        sprintf(content, "%d", i % 10);
+        pipeline_put(data->pipeline, msg_init_string(content));
+    }
+    pipeline_close(data->pipeline);
+    return NULL;
+}
+
+// Alimenta la pipeline da un produttore concorrente e conta i risultati
+int run_and_count(pipeline_t *pipeline, int num_msgs, const char *expected_suffix)
+{
+    pthread_t producer_tid;
+    producer_data_t data = {pipeline, num_msgs};
+    pthread_create(&producer_tid, NULL, producer_thread, &data);
+
+    int count = 0;
+    msg_t *msg;
+    while ((msg = pipeline_get(pipeline)) != BUFFER_ERROR)
+    {
+        char *result = (char *)msg->content;
+        CU_ASSERT_STRING_EQUAL(result + strlen(result) - strlen(expected_suffix), expected_suffix);
+        count++;
+        msg_destroy_string(msg);
+    }
+
+    pthread_join(producer_tid, NULL);
+    return count;
+}
+
+// === Test Case ===
+
+// Stadi con più worker: tutti i messaggi attraversano tutti gli stadi e la chiusura si propaga
+void test_parallel_stages_drain_on_close(void)
+{
+    const int NUM_MSGS = 500;
+    char a = 'A', b = 'B';
+    pipeline_t *pipeline = pipeline_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pipeline);
+
+    pipeline_add_stage(pipeline, filter_odd_stage, NULL, 3, 8);
+    pipeline_add_stage(pipeline, append_stage, &a, 2, 2);
+    pipeline_add_stage(pipeline, append_stage, &b, 4, 16);
+    pipeline_start(pipeline, true); // Nessuno stadio ha un solo worker: niente fusione
+
+    CU_ASSERT_EQUAL(run_and_count(pipeline, NUM_MSGS, "AB"), NUM_MSGS / 2);
+
+    pipeline_stage_stats_t stats;
+    pipeline_stats(pipeline, 0, &stats);
+    CU_ASSERT_EQUAL(stats.processed, (unsigned long)NUM_MSGS);
+    CU_ASSERT_FALSE(stats.fused);
+    CU_ASSERT_EQUAL(stats.capacity, 8);
+    CU_ASSERT_EQUAL(stats.occupancy, 0);
+    pipeline_stats(pipeline, 2, &stats);
+    CU_ASSERT_EQUAL(stats.processed, (unsigned long)(NUM_MSGS / 2)); // Il filtro ha scartato i dispari
+    CU_ASSERT(stats.throughput > 0.0);
+
+    pipeline_destroy(pipeline);
+}
+
+// Stadi adiacenti con un solo worker vengono fusi, senza cambiare i risultati
+void test_fused_single_worker_stages(void)
+{
+    const int NUM_MSGS = 300;
+    char a = 'A';
+    pipeline_t *pipeline = pipeline_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pipeline);
+
+    pipeline_add_stage(pipeline, filter_odd_stage, NULL, 1, 8);
+    pipeline_add_stage(pipeline, append_stage, &a, 1, 8);
+    pipeline_add_stage(pipeline, append_stage, &a, 2, 8);
+    pipeline_start(pipeline, true);
+
+    CU_ASSERT_PTR_NOT_NULL(pipeline->stages[0].input);
+    CU_ASSERT_PTR_NULL(pipeline->stages[1].input);
+    CU_ASSERT_PTR_NOT_NULL(pipeline->stages[2].input);
+
+    CU_ASSERT_EQUAL(run_and_count(pipeline, NUM_MSGS, "AA"), NUM_MSGS / 2);
+
+    pipeline_stage_stats_t stats;
+    pipeline_stats(pipeline, 1, &stats);
+    CU_ASSERT_TRUE(stats.fused);
+    CU_ASSERT_EQUAL(stats.capacity, 0);
+    CU_ASSERT_EQUAL(stats.processed, (unsigned long)(NUM_MSGS / 2));
+
+    pipeline_destroy(pipeline);
+}
+
+// Distruzione di una pipeline con risultati mai consumati
+void test_destroy_with_pending_results(void)
+{
+    char a = 'A';
+    pipeline_t *pipeline = pipeline_init(1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pipeline);
+
+    pipeline_add_stage(pipeline, append_stage, &a, 2, 2);
+    pipeline_start(pipeline, false);
+
+    // Uscita piena, un messaggio per worker ed ingresso pieno
+    for (int i = 0; i < 5; i++)
+    {
+        pipeline_put(pipeline, msg_init_string("X"));
+    }
+    sleep(1);
+
+    pipeline_destroy(pipeline); // Non deve restare bloccata sui buffer pieni
+}
+
+// Pipeline senza stadi: inserimento rifiutato e distruzione senza accessi fuori limite
+void test_no_stages(void)
+{
+    pipeline_t *pipeline = pipeline_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pipeline);
+    pipeline_start(pipeline, false);
+
+    msg_t *msg = msg_init_string("X");
+    CU_ASSERT_PTR_EQUAL(pipeline_put(pipeline, msg), BUFFER_ERROR);
+    msg_destroy_string(msg); // Rifiutato: resta nostro
+
+    pipeline_destroy(pipeline);
+}
+
+// Capacità nulla e operazioni prima dell'avvio: rifiutate invece di bloccare o accedere a NULL
+void test_invalid_stage_and_not_started(void)
+{
+    char a = 'A';
+    pipeline_t *pipeline = pipeline_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pipeline);
+
+    CU_ASSERT_EQUAL(pipeline_add_stage(pipeline, append_stage, &a, 1, 0), -1);
+    CU_ASSERT_EQUAL(pipeline->num_stages, 0);
+    CU_ASSERT_EQUAL(pipeline_add_stage(pipeline, append_stage, &a, 1, 4), 0);
+
+    msg_t *msg = msg_init_string("X");
+    CU_ASSERT_PTR_EQUAL(pipeline_put(pipeline, msg), BUFFER_ERROR);
+    CU_ASSERT_PTR_EQUAL(pipeline_close(pipeline), BUFFER_ERROR);
+
+    pipeline_start(pipeline, false);
+    CU_ASSERT_EQUAL(pipeline_add_stage(pipeline, append_stage, &a, 1, 4), -1);
+    CU_ASSERT_PTR_EQUAL(pipeline_put(pipeline, msg), msg);
+    CU_ASSERT_PTR_NULL(pipeline_close(pipeline));
+
+    msg_t *result = pipeline_get(pipeline);
+    CU_ASSERT_STRING_EQUAL(result->content, "XA");
+    result->msg_destroy(result);
+    CU_ASSERT_PTR_EQUAL(pipeline_get(pipeline), BUFFER_ERROR);
+
+    pipeline_destroy(pipeline);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Pipeline_Suite", init_suite_pipeline, clean_suite_pipeline);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Stadi paralleli: chiusura propagata e svuotamento completo", test_parallel_stages_drain_on_close)) ||
+        (NULL == CU_add_test(pSuite, "Fusione di stadi adiacenti con un solo worker", test_fused_single_worker_stages)) ||
+        (NULL == CU_add_test(pSuite, "Distruzione con risultati non consumati", test_destroy_with_pending_results)) ||
+        (NULL == CU_add_test(pSuite, "Pipeline senza stadi", test_no_stages)) ||
+        (NULL == CU_add_test(pSuite, "Stadio di capacità nulla ed operazioni prima dell'avvio", test_invalid_stage_and_not_started)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
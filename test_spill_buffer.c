@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "spill_buffer.h"
+#include "message.h"
+
+static char spill_dir[] = "/tmp/spill_buffer_XXXXXX";
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_spill_buffer(void)
+{
+    return mkdtemp(spill_dir) == NULL ? -1 : 0;
+}
+
+int clean_suite_spill_buffer(void)
+{
+    // I segmenti vengono rimossi appena creati: la directory deve essere vuota
+    return rmdir(spill_dir) == 0 ? 0 : -1;
+}
+
+// Codec delle stringhe che conta i messaggi ricreati
+static int decoded = 0;
+
+static msg_t *counting_read(const void *data, size_t length)
+{
+    decoded++;
+    return spill_codec_string.read(data, length);
+}
+
+// === Strutture dati per i thread helper ===
+typedef struct
+{
+    spill_buffer_t *buffer;
+    int num_ops;
+    int success_count;
+} thread_data_t;
+
+// === Funzioni helper per i thread ===
+void *spill_consumer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    data->success_count = 0;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        msg_t *msg = get_spill_bloccante(data->buffer);
+        if (msg != BUFFER_ERROR)
+        {
+            data->success_count++;
+            msg->msg_destroy(msg);
+        }
+    }
+    return NULL;
+}
+
+// === Test Case ===
+
+// Con la memoria piena i messaggi finiscono sul log e vengono riletti nell'ordine di scrittura
+void test_overflow_spills_and_replays_in_order(void)
+{
+    const int NUM_MSGS = 100;
+    spill_buffer_t *buffer = spill_buffer_init(2, spill_dir, 4096, 2, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    char content[32];
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        sprintf(content, "SPILL_%d", i);
+        msg_t *msg = msg_init_string(content);
+        msg_t *result = put_spill(buffer, msg); // Mai bloccante
+
+        // Solo i messaggi rimasti in memoria vengono restituiti
+        if (i < 2)
+        {
+            CU_ASSERT_PTR_EQUAL(result, msg);
+        }
+        else
+        {
+            CU_ASSERT_PTR_EQUAL(result, SPILL_ON_DISK);
+        }
+    }
+
+    CU_ASSERT_EQUAL(buffer->memory->current_size, 2);
+    CU_ASSERT_EQUAL(buffer->spilled, (unsigned long)(NUM_MSGS - 2));
+
+    // Prima i messaggi in memoria, poi quelli sul log
+    for (int i = 0; i < 2; i++)
+    {
+        msg_t *msg = get_spill_non_bloccante(buffer);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+        CU_ASSERT_NSTRING_EQUAL(msg->content, "SPILL_", 6);
+        msg_destroy_string(msg);
+    }
+
+    // Finché il log non è vuoto le put non lo scavalcano
+    put_spill(buffer, msg_init_string("LATE"));
+    CU_ASSERT_EQUAL(buffer->memory->current_size, 0);
+
+    for (int i = 2; i < NUM_MSGS; i++)
+    {
+        msg_t *msg = get_spill_bloccante(buffer);
+        sprintf(content, "SPILL_%d", i);
+        CU_ASSERT_STRING_EQUAL(msg->content, content);
+        msg_destroy_string(msg);
+    }
+    msg_t *late = get_spill_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(late->content, "LATE");
+    msg_destroy_string(late);
+
+    CU_ASSERT_PTR_EQUAL(get_spill_non_bloccante(buffer), BUFFER_ERROR);
+    CU_ASSERT_EQUAL(buffer->total_spilled, (unsigned long)(NUM_MSGS - 1));
+    CU_ASSERT_EQUAL(buffer->total_replayed, buffer->total_spilled);
+
+    spill_buffer_destroy(buffer);
+}
+
+// Segmenti piccoli: rotazione, riuso dei segmenti riletti e record più grandi di un segmento
+void test_segment_rotation_and_recycling(void)
+{
+    spill_buffer_t *buffer = spill_buffer_init(1, spill_dir, 64, 4, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    put_spill(buffer, msg_init_string("IN_MEMORY"));
+    for (int round = 0; round < 3; round++)
+    {
+        // 40 byte per record: un record per segmento
+        for (int i = 0; i < 8; i++)
+        {
+            put_spill(buffer, msg_init_string("0123456789012345678901234567890"));
+        }
+        while (buffer->spilled > 0)
+        {
+            msg_t *msg = get_spill_non_bloccante(buffer);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+            msg_destroy_string(msg);
+        }
+        CU_ASSERT_EQUAL(buffer->num_free_segments, 4);
+    }
+    // Dopo il primo giro servono al più 4 segmenti nuovi per giro (8 in uso, 4 riusati)
+    CU_ASSERT(buffer->next_segment_id <= 8 + 2 * 4);
+
+    // Con la memoria occupata il record più grande di un segmento va sul log
+    char big[200];
+    memset(big, 'X', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    put_spill(buffer, msg_init_string("FILLER"));
+    CU_ASSERT_PTR_EQUAL(put_spill(buffer, msg_init_string(big)), SPILL_ON_DISK);
+    msg_t *msg = get_spill_non_bloccante(buffer);
+    CU_ASSERT_STRING_EQUAL(msg->content, "FILLER");
+    msg_destroy_string(msg);
+    msg = get_spill_non_bloccante(buffer);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_STRING_EQUAL(msg->content, big);
+    msg_destroy_string(msg);
+
+    spill_buffer_destroy(buffer);
+}
+
+// Un consumatore sospeso viene svegliato da messaggi riversati su disco
+void test_blocked_consumer_woken_by_spilled_messages(void)
+{
+    const int NUM_MSGS = 50;
+    pthread_t c_tid;
+    thread_data_t data;
+    spill_buffer_t *buffer = spill_buffer_init(1, spill_dir, 1024, 1, &spill_codec_string);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    data.buffer = buffer;
+    data.num_ops = NUM_MSGS;
+    pthread_create(&c_tid, NULL, spill_consumer_thread, &data);
+    sleep(1);
+
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        put_spill(buffer, msg_init_string("WAKE"));
+    }
+
+    pthread_join(c_tid, NULL);
+    CU_ASSERT_EQUAL(data.success_count, NUM_MSGS);
+    CU_ASSERT_EQUAL(buffer->spilled, 0);
+
+    spill_buffer_destroy(buffer);
+}
+
+// La distruzione scarta i record su disco senza ricrearli con il codec
+void test_destroy_discards_spilled_records(void)
+{
+    spill_codec_t codec = spill_codec_string;
+    codec.read = counting_read;
+    decoded = 0;
+
+    spill_buffer_t *buffer = spill_buffer_init(1, spill_dir, 256, 1, &codec);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+
+    for (int i = 0; i < 20; i++)
+    {
+        put_spill(buffer, msg_init_string("DISCARDED"));
+    }
+    CU_ASSERT_EQUAL(buffer->spilled, 19);
+
+    // Un record riletto passa dal codec, gli altri no
+    msg_destroy_string(get_spill_non_bloccante(buffer));
+    msg_destroy_string(get_spill_non_bloccante(buffer));
+    CU_ASSERT_EQUAL(decoded, 1);
+
+    spill_buffer_destroy(buffer);
+    CU_ASSERT_EQUAL(decoded, 1);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Spill_Buffer_Suite", init_suite_spill_buffer, clean_suite_spill_buffer);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Riversamento su disco e rilettura nell'ordine di scrittura", test_overflow_spills_and_replays_in_order)) ||
+        (NULL == CU_add_test(pSuite, "Rotazione e riuso dei segmenti", test_segment_rotation_and_recycling)) ||
+        (NULL == CU_add_test(pSuite, "Consumatore sospeso svegliato da messaggi su disco", test_blocked_consumer_woken_by_spilled_messages)) ||
+        (NULL == CU_add_test(pSuite, "Distruzione senza ricreare i record su disco", test_destroy_discards_spilled_records)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
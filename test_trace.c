@@ -0,0 +1,324 @@
+/*
+ * Test del tracciamento delle latenze: va compilato con -DBUFFER_TRACE
+ *   gcc -DBUFFER_TRACE -pthread buffer.c message.c mem_alloc.c msg_pool.c trace.c test_trace.c -lcunit
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+#include "buffer.h"
+#include "message.h"
+#include "trace.h"
+
+#ifndef BUFFER_TRACE
+#error "test_trace.c va compilato con -DBUFFER_TRACE"
+#endif
+
+// === Funzioni di Init/Cleanup per la Suite ===
+int init_suite_trace(void)
+{
+    return 0;
+}
+
+int clean_suite_trace(void)
+{
+    trace_set_sampling(0);
+    return 0;
+}
+
+// === Strutture dati per i thread helper ===
+typedef struct
+{
+    buffer_t *buffer;
+    int num_ops;
+} thread_data_t;
+
+// === Funzioni helper per i thread ===
+void *trace_producer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        put_bloccante(data->buffer, msg_init_string("TRACE"));
+    }
+    return NULL;
+}
+
+void *trace_consumer_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        msg_t *msg = get_bloccante(data->buffer);
+        msg->msg_destroy(msg);
+    }
+    return NULL;
+}
+
+// Produttore e consumatore nello stesso thread nuovo: il contatore di campionamento riparte da zero
+void *trace_put_get_thread(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        put_bloccante(data->buffer, msg_init_string("TRACE"));
+        msg_t *msg = get_bloccante(data->buffer);
+        msg->msg_destroy(msg);
+    }
+    return NULL;
+}
+
+// Estrae i messaggi senza distruggerli: li distruggerà un altro thread
+typedef struct
+{
+    buffer_t *buffer;
+    msg_t **msgs;
+    int num_ops;
+} extract_data_t;
+
+void *trace_extract_thread(void *arg)
+{
+    extract_data_t *data = (extract_data_t *)arg;
+    for (int i = 0; i < data->num_ops; i++)
+    {
+        data->msgs[i] = get_bloccante(data->buffer);
+    }
+    return NULL;
+}
+
+// === Test Case ===
+
+// L'attesa nel buffer e l'elaborazione del consumatore finiscono in istogrammi distinti
+void test_queueing_vs_processing(void)
+{
+    const int NUM_MSGS = 10;
+    trace_snapshot_t snapshot;
+    buffer_t *buffer = buffer_init(NUM_MSGS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    trace_set_sampling(1);
+
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        put_bloccante(buffer, msg_init_string("SLOW_QUEUE"));
+    }
+    usleep(20000); // 20 ms nel buffer
+
+    msg_t *msgs[NUM_MSGS];
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        msgs[i] = get_non_bloccante(buffer);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(msgs[i]);
+    }
+    usleep(5000); // 5 ms di elaborazione
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        msg_destroy_string(msgs[i]);
+    }
+
+    buffer_trace_snapshot(buffer, &snapshot);
+    CU_ASSERT_EQUAL(snapshot.queueing.count, (uint64_t)NUM_MSGS);
+    CU_ASSERT_EQUAL(snapshot.processing.count, (uint64_t)NUM_MSGS);
+
+    // Errore relativo degli intervalli < 6.25%
+    CU_ASSERT(trace_percentile(&snapshot.queueing, 50) >= 20000000ULL * 15 / 16);
+    CU_ASSERT(trace_percentile(&snapshot.processing, 50) >= 5000000ULL * 15 / 16);
+    CU_ASSERT(trace_percentile(&snapshot.processing, 99) < trace_percentile(&snapshot.queueing, 1));
+    CU_ASSERT(trace_percentile(&snapshot.queueing, 100) <= snapshot.queueing.max_ns);
+    CU_ASSERT(snapshot.queueing.sum_ns >= (uint64_t)NUM_MSGS * 20000000ULL * 15 / 16);
+
+    buffer_destroy(buffer);
+    trace_set_sampling(0);
+}
+
+// Un inserimento ogni n viene campionato
+void test_sampling_rate(void)
+{
+    pthread_t tid;
+    thread_data_t data;
+    trace_snapshot_t snapshot;
+    buffer_t *buffer = buffer_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    trace_set_sampling(10);
+
+    data.buffer = buffer;
+    data.num_ops = 1000;
+    pthread_create(&tid, NULL, trace_put_get_thread, &data);
+    pthread_join(tid, NULL);
+
+    buffer_trace_snapshot(buffer, &snapshot);
+    CU_ASSERT_EQUAL(snapshot.queueing.count, 100);
+    CU_ASSERT_EQUAL(snapshot.processing.count, 100);
+
+    buffer_destroy(buffer);
+    trace_set_sampling(0);
+}
+
+// Senza campionamento nessun thread registra i propri istogrammi
+void test_sampling_off(void)
+{
+    pthread_t tid;
+    thread_data_t data;
+    trace_snapshot_t snapshot;
+    buffer_t *buffer = buffer_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    trace_set_sampling(0);
+
+    data.buffer = buffer;
+    data.num_ops = 1000;
+    pthread_create(&tid, NULL, trace_put_get_thread, &data);
+    pthread_join(tid, NULL);
+
+    buffer_trace_snapshot(buffer, &snapshot);
+    CU_ASSERT_EQUAL(snapshot.queueing.count, 0);
+    CU_ASSERT_EQUAL(snapshot.processing.count, 0);
+    CU_ASSERT_PTR_NULL(buffer->trace.threads);
+    CU_ASSERT_EQUAL(trace_percentile(&snapshot.queueing, 50), 0);
+
+    buffer_destroy(buffer);
+}
+
+// Più produttori e consumatori: ogni messaggio viene contato una sola volta
+void test_concurrent_threads_merged(void)
+{
+    const int NUM_THREADS = 4;
+    const int NUM_OPS = 5000;
+    pthread_t tids[2 * NUM_THREADS];
+    thread_data_t data;
+    trace_snapshot_t snapshot;
+    buffer_t *buffer = buffer_init(8);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    trace_set_sampling(1);
+
+    data.buffer = buffer;
+    data.num_ops = NUM_OPS;
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_create(&tids[i], NULL, trace_producer_thread, &data);
+        pthread_create(&tids[NUM_THREADS + i], NULL, trace_consumer_thread, &data);
+    }
+
+    // Lettura concorrente con i thread che scrivono
+    buffer_trace_snapshot(buffer, &snapshot);
+    CU_ASSERT(snapshot.queueing.count <= (uint64_t)(NUM_THREADS * NUM_OPS));
+
+    for (int i = 0; i < 2 * NUM_THREADS; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+
+    buffer_trace_snapshot(buffer, &snapshot);
+    CU_ASSERT_EQUAL(snapshot.queueing.count, (uint64_t)(NUM_THREADS * NUM_OPS));
+    CU_ASSERT_EQUAL(snapshot.processing.count, (uint64_t)(NUM_THREADS * NUM_OPS));
+
+    buffer_destroy(buffer);
+    trace_set_sampling(0);
+}
+
+// Messaggi distrutti da un thread diverso da quello che li ha estratti
+void test_cross_thread_destroy(void)
+{
+    const int NUM_MSGS = 32; // Entro i posti della tabella dei messaggi in elaborazione
+    pthread_t tid;
+    msg_t *msgs[NUM_MSGS];
+    trace_snapshot_t snapshot;
+    buffer_t *buffer = buffer_init(NUM_MSGS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    trace_set_sampling(1);
+
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        put_bloccante(buffer, msg_init_string("TRACE"));
+    }
+    extract_data_t data = {buffer, msgs, NUM_MSGS};
+    pthread_create(&tid, NULL, trace_extract_thread, &data);
+    pthread_join(tid, NULL);
+    trace_set_sampling(0);
+
+    usleep(5000); // 5 ms di elaborazione
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        msg_destroy_string(msgs[i]);
+    }
+
+    // Ogni elaborazione è misurata una volta e nessun messaggio resta in sospeso
+    buffer_trace_snapshot(buffer, &snapshot);
+    CU_ASSERT_EQUAL(snapshot.queueing.count, (uint64_t)NUM_MSGS);
+    CU_ASSERT_EQUAL(snapshot.processing.count, (uint64_t)NUM_MSGS);
+    CU_ASSERT(trace_percentile(&snapshot.processing, 1) >= 5000000ULL * 15 / 16);
+    CU_ASSERT_EQUAL(atomic_load(&trace_inflight_count), 0);
+
+    buffer_destroy(buffer);
+}
+
+// Messaggi estratti da un buffer distrutto non vengono più seguiti
+void test_destroy_buffer_with_messages_in_flight(void)
+{
+    buffer_t *buffer = buffer_init(4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    trace_set_sampling(1);
+
+    put_bloccante(buffer, msg_init_string("A"));
+    put_bloccante(buffer, msg_init_string("B"));
+    msg_t *a = get_bloccante(buffer);
+    msg_t *b = get_bloccante(buffer);
+    trace_set_sampling(0);
+    CU_ASSERT_EQUAL(atomic_load(&trace_inflight_count), 2);
+
+    buffer_destroy(buffer); // Ripulisce la tabella: nessun accesso agli istogrammi deallocati
+    CU_ASSERT_EQUAL(atomic_load(&trace_inflight_count), 0);
+    msg_destroy_string(a);
+    msg_destroy_string(b);
+}
+
+// === Main Function per CUnit ===
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    // Inizializza il registro dei test di CUnit
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    // Aggiungi una suite al registro
+    pSuite = CU_add_suite("Trace_Suite", init_suite_trace, clean_suite_trace);
+    if (NULL == pSuite)
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Aggiungi i test alla suite
+    if (
+        (NULL == CU_add_test(pSuite, "Attesa ed elaborazione misurate separatamente", test_queueing_vs_processing)) ||
+        (NULL == CU_add_test(pSuite, "Frequenza di campionamento", test_sampling_rate)) ||
+        (NULL == CU_add_test(pSuite, "Campionamento disattivato", test_sampling_off)) ||
+        (NULL == CU_add_test(pSuite, "Istogrammi per thread sommati su richiesta", test_concurrent_threads_merged)) ||
+        (NULL == CU_add_test(pSuite, "Distruzione in un thread diverso da quello che estrae", test_cross_thread_destroy)) ||
+        (NULL == CU_add_test(pSuite, "Distruzione del buffer con messaggi in elaborazione", test_destroy_buffer_with_messages_in_flight)))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Esegui tutti i test usando l'interfaccia Basic
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    printf("\n");
+    CU_basic_show_failures(CU_get_failure_list());
+    printf("\n\n");
+
+    // Ottieni il numero di test falliti
+    unsigned int num_failures = CU_get_number_of_failures();
+
+    // Pulisci il registro
+    CU_cleanup_registry();
+
+    // Restituisce un codice di errore se ci sono stati fallimenti
+    return (num_failures > 0) ? 1 : CU_get_error();
+}
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace.h"
+
+#ifdef BUFFER_TRACE
+
+// Messaggi campionati estratti e non ancora distrutti, in tutti i thread:
+// gruppi indicizzati dall'indirizzo del messaggio, ciascuno con il proprio mutex
+#define TRACE_INFLIGHT_GROUP_BITS 6
+#define TRACE_INFLIGHT_GROUPS (1U << TRACE_INFLIGHT_GROUP_BITS)
+#define TRACE_INFLIGHT_WAYS 8
+
+// Oltre questo tempo un messaggio estratto si considera perso (distrutto senza aggancio)
+#define TRACE_INFLIGHT_TTL_NS (10ULL * 1000000000ULL)
+
+// Messaggio campionato in elaborazione
+typedef struct trace_inflight {
+    msg_t* msg;              // NULL se il posto è libero
+    uint64_t stamp;          // istante di estrazione
+    trace_t* trace;          // buffer da cui è stato estratto
+} trace_inflight_t;
+
+// Gruppo della tabella: used permette di saltarlo senza mutex se è vuoto
+typedef struct trace_inflight_group {
+    pthread_mutex_t mutex;
+    atomic_uint used;
+    trace_inflight_t entries[TRACE_INFLIGHT_WAYS];
+} trace_inflight_group_t;
+
+atomic_uint trace_sample_every = 0;
+_Thread_local unsigned int trace_countdown = 0;
+atomic_uint trace_inflight_count = 0;
+
+// Incrementata ad ogni trace_destroy: invalida gli istogrammi in cache dei thread
+static atomic_ulong trace_generation = 0;
+
+// Tabella condivisa: un messaggio può essere distrutto da un thread diverso da
+// quello che lo ha estratto; trace_destroy la ripulisce un gruppo alla volta
+static trace_inflight_group_t inflight[TRACE_INFLIGHT_GROUPS];
+static pthread_once_t inflight_once = PTHREAD_ONCE_INIT;
+
+// Ultimi istogrammi usati dal thread
+static _Thread_local trace_t* cached_trace = NULL;
+static _Thread_local trace_thread_t* cached_thread = NULL;
+static _Thread_local unsigned long cached_generation = 0;
+
+// Intervallo dell'istogramma: lineare sotto 16 ns, poi 16 sotto-intervalli per potenza di 2
+static unsigned int intervallo(uint64_t ns) {
+    if (ns < TRACE_SUB_BUCKETS) {
+        return (unsigned int) ns;
+    }
+
+    unsigned int exponent = 63 - (unsigned int) __builtin_clzll(ns);
+    unsigned int index = (exponent - 3) * TRACE_SUB_BUCKETS + (unsigned int) ((ns >> (exponent - 4)) & (TRACE_SUB_BUCKETS - 1));
+
+    return index < TRACE_BUCKETS ? index : TRACE_BUCKETS - 1;
+}
+
+// Valore massimo rappresentato da un intervallo
+static uint64_t limite_superiore(unsigned int index) {
+    if (index < TRACE_SUB_BUCKETS) {
+        return index;
+    }
+
+    unsigned int exponent = index / TRACE_SUB_BUCKETS + 3;
+    uint64_t sub = index % TRACE_SUB_BUCKETS;
+
+    return ((TRACE_SUB_BUCKETS + sub + 1) << (exponent - 4)) - 1;
+}
+
+// Registra un campione; il thread è l'unico scrittore, bastano load e store
+static void registra(trace_counters_t* counters, uint64_t ns) {
+    atomic_ullong* count = &counters->counts[intervallo(ns)];
+
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&counters->sum_ns, atomic_load_explicit(&counters->sum_ns, memory_order_relaxed) + ns,
+                          memory_order_relaxed);
+    if (ns > atomic_load_explicit(&counters->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&counters->max_ns, ns, memory_order_relaxed);
+    }
+}
+
+// Istogrammi del thread corrente per il buffer, registrati al primo uso
+static trace_thread_t* istogrammi_thread(trace_t* trace, unsigned long generation) {
+    if (cached_trace == trace && cached_generation == generation) {
+        return cached_thread;
+    }
+
+    pthread_t self = pthread_self();
+    trace_thread_t* thread = atomic_load_explicit(&trace->threads, memory_order_acquire);
+    while (thread != NULL && !pthread_equal(thread->owner, self)) {
+        thread = thread->next;
+    }
+
+    if (thread == NULL) {
+        thread = (trace_thread_t*) calloc(1, sizeof(trace_thread_t));
+        thread->owner = self;
+        thread->next = atomic_load_explicit(&trace->threads, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&trace->threads, &thread->next, thread,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+
+    cached_trace = trace;
+    cached_thread = thread;
+    cached_generation = generation;
+    return thread;
+}
+
+// Somma dei contatori di un thread in un istogramma
+static void somma(trace_histogram_t* histogram, trace_counters_t* counters) {
+    for (unsigned int i = 0; i < TRACE_BUCKETS; i++) {
+        uint64_t count = atomic_load_explicit(&counters->counts[i], memory_order_relaxed);
+        histogram->counts[i] += count;
+        histogram->count += count;
+    }
+    histogram->sum_ns += atomic_load_explicit(&counters->sum_ns, memory_order_relaxed);
+
+    uint64_t max_ns = atomic_load_explicit(&counters->max_ns, memory_order_relaxed);
+    if (max_ns > histogram->max_ns) {
+        histogram->max_ns = max_ns;
+    }
+}
+
+// Inizializza i mutex dei gruppi della tabella
+static void inizializza_tabella(void) {
+    for (unsigned int i = 0; i < TRACE_INFLIGHT_GROUPS; i++) {
+        pthread_mutex_init(&inflight[i].mutex, NULL);
+        atomic_init(&inflight[i].used, 0);
+    }
+}
+
+// Gruppo della tabella di un messaggio (hash di Fibonacci dell'indirizzo)
+static trace_inflight_group_t* gruppo(msg_t* msg) {
+    uint64_t hash = (uint64_t) (uintptr_t) msg * 0x9E3779B97F4A7C15ULL;
+    return &inflight[hash >> (64 - TRACE_INFLIGHT_GROUP_BITS)];
+}
+
+// Inizializza il tracciamento di un buffer
+void trace_init(trace_t* trace) {
+    pthread_once(&inflight_once, inizializza_tabella);
+    atomic_init(&trace->threads, NULL);
+}
+
+// Libera un posto della tabella (mutex del gruppo acquisito)
+static void libera_posto(trace_inflight_group_t* group, trace_inflight_t* entry) {
+    entry->msg = NULL;
+    atomic_fetch_sub_explicit(&group->used, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&trace_inflight_count, 1, memory_order_relaxed);
+}
+
+// Dealloca gli istogrammi di tutti i thread
+void trace_destroy(trace_t* trace) {
+    // I messaggi estratti dal buffer non ancora distrutti non vengono più misurati;
+    // dopo aver ripulito un gruppo nessuna distruzione può più usare questi istogrammi
+    atomic_fetch_add(&trace_generation, 1);
+    for (unsigned int i = 0; i < TRACE_INFLIGHT_GROUPS; i++) {
+        trace_inflight_group_t* group = &inflight[i];
+        pthread_mutex_lock(&group->mutex);
+        for (unsigned int j = 0; j < TRACE_INFLIGHT_WAYS; j++) {
+            if (group->entries[j].msg != NULL && group->entries[j].trace == trace) {
+                libera_posto(group, &group->entries[j]);
+            }
+        }
+        pthread_mutex_unlock(&group->mutex);
+    }
+
+    trace_thread_t* thread = atomic_load(&trace->threads);
+    while (thread != NULL) {
+        trace_thread_t* next = thread->next;
+        free(thread);
+        thread = next;
+    }
+}
+
+// Imposta la frequenza di campionamento
+void trace_set_sampling(unsigned int every) {
+    atomic_store(&trace_sample_every, every);
+}
+
+// Istante corrente dal clock monotono (vDSO, nessuna system call)
+uint64_t trace_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+    return ns != 0 ? ns : 1;
+}
+
+// Registra l'attesa di un messaggio campionato e ne segue l'elaborazione
+void trace_record_dequeue(trace_t* trace, uint64_t stamp, msg_t* msg) {
+    unsigned long generation = atomic_load_explicit(&trace_generation, memory_order_relaxed);
+    trace_thread_t* thread = istogrammi_thread(trace, generation);
+    uint64_t now = trace_now();
+
+    registra(&thread->queueing, now > stamp ? now - stamp : 0);
+
+    // Stesso indirizzo (il precedente è stato distrutto senza aggancio), posto
+    // libero, posto scaduto, altrimenti si rinuncia al messaggio più vecchio del gruppo
+    trace_inflight_group_t* group = gruppo(msg);
+    pthread_mutex_lock(&group->mutex);
+    trace_inflight_t* same = NULL;
+    trace_inflight_t* free_entry = NULL;
+    trace_inflight_t* oldest = &group->entries[0];
+    for (unsigned int i = 0; i < TRACE_INFLIGHT_WAYS && same == NULL; i++) {
+        trace_inflight_t* candidate = &group->entries[i];
+        if (candidate->msg == msg) {
+            same = candidate;
+        } else if (candidate->msg == NULL || (now > candidate->stamp && now - candidate->stamp > TRACE_INFLIGHT_TTL_NS)) {
+            free_entry = free_entry != NULL ? free_entry : candidate;
+        } else if (candidate->stamp < oldest->stamp) {
+            oldest = candidate;
+        }
+    }
+    trace_inflight_t* entry = same != NULL ? same : free_entry != NULL ? free_entry : oldest;
+
+    if (entry->msg == NULL) {
+        atomic_fetch_add_explicit(&group->used, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&trace_inflight_count, 1, memory_order_relaxed);
+    }
+    entry->msg = msg;
+    entry->stamp = now;
+    entry->trace = trace;
+    pthread_mutex_unlock(&group->mutex);
+}
+
+// Registra l'elaborazione di un messaggio campionato, in qualunque thread venga
+// distrutto; si blocca solo il gruppo del messaggio, e solo se non è vuoto
+void trace_record_destroy(msg_t* msg) {
+    trace_inflight_group_t* group = gruppo(msg);
+
+    if (atomic_load_explicit(&group->used, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    uint64_t now = trace_now();
+
+    pthread_mutex_lock(&group->mutex);
+    for (unsigned int i = 0; i < TRACE_INFLIGHT_WAYS; i++) {
+        trace_inflight_t* entry = &group->entries[i];
+        if (entry->msg == NULL) {
+            continue;
+        }
+
+        uint64_t elapsed = now > entry->stamp ? now - entry->stamp : 0;
+        if (entry->msg == msg) {
+            // Con il mutex del gruppo acquisito trace_destroy non può deallocare il buffer
+            if (elapsed <= TRACE_INFLIGHT_TTL_NS) {
+                unsigned long generation = atomic_load_explicit(&trace_generation, memory_order_relaxed);
+                registra(&istogrammi_thread(entry->trace, generation)->processing, elapsed);
+            }
+            libera_posto(group, entry);
+        } else if (elapsed > TRACE_INFLIGHT_TTL_NS) {
+            libera_posto(group, entry); // Scaduto: non resta nella tabella per sempre
+        }
+    }
+    pthread_mutex_unlock(&group->mutex);
+}
+
+// Somma gli istogrammi di tutti i thread del buffer
+void trace_merge(trace_t* trace, trace_snapshot_t* snapshot) {
+    memset(snapshot, 0, sizeof(trace_snapshot_t));
+
+    trace_thread_t* thread = atomic_load_explicit(&trace->threads, memory_order_acquire);
+    while (thread != NULL) {
+        somma(&snapshot->queueing, &thread->queueing);
+        somma(&snapshot->processing, &thread->processing);
+        thread = thread->next;
+    }
+}
+
+// Latenza sotto cui cade la percentuale percentile dei campioni
+uint64_t trace_percentile(const trace_histogram_t* histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t) (percentile / 100.0 * (double) histogram->count + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < TRACE_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target) {
+            uint64_t upper = limite_superiore(i);
+            return upper < histogram->max_ns ? upper : histogram->max_ns;
+        }
+    }
+
+    return histogram->max_ns;
+}
+
+#endif // BUFFER_TRACE
@@ -0,0 +1,140 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Tracciamento della latenza dei messaggi di buffer_t.
+ *
+ * Compilando con -DBUFFER_TRACE (e trace.c) un inserimento ogni n,
+ * scelti con trace_set_sampling(n), viene marcato con l'istante in cui
+ * il messaggio entra nel buffer:
+ *  - all'estrazione si registra il tempo di attesa nel buffer (queueing);
+ *  - alla distruzione, in qualunque thread avvenga, il tempo di
+ *    elaborazione del consumatore (processing); i messaggi estratti e
+ *    non ancora distrutti sono in una tabella condivisa di 64 gruppi
+ *    da 8 posti, scelti dall'indirizzo del messaggio, e dopo 10 s non
+ *    vengono più misurati, così un messaggio distrutto senza aggancio
+ *    non resta nella tabella.
+ * I campioni finiscono in istogrammi log-lineari in stile HDR (16
+ * sotto-intervalli per potenza di 2, errore relativo < 6.25%) privati
+ * di ogni coppia thread/buffer: un solo scrittore, nessun lock né
+ * operazione atomica read-modify-write; trace_merge li somma su
+ * richiesta, anche mentre i thread continuano a scrivere. Una
+ * distruzione acquisisce solo il mutex del gruppo del messaggio, e solo
+ * se il gruppo contiene messaggi campionati.
+ * Senza -DBUFFER_TRACE le funzioni di aggancio sono vuote ed il buffer
+ * non ha campi aggiuntivi; con -DBUFFER_TRACE ed il campionamento
+ * disattivato (default) resta un confronto per inserimento ed estrazione.
+ */
+
+#include "message.h"
+
+#ifdef BUFFER_TRACE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define TRACE_SUB_BUCKETS 16
+#define TRACE_BUCKETS (48 * TRACE_SUB_BUCKETS) // fino a 2^48 ns (circa 78 ore)
+
+// istogramma delle latenze, in nanosecondi
+typedef struct trace_histogram {
+    uint64_t counts[TRACE_BUCKETS];
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} trace_histogram_t;
+
+// latenze di un buffer, sommate su tutti i thread
+typedef struct trace_snapshot {
+    trace_histogram_t queueing;    // dall'inserimento all'estrazione
+    trace_histogram_t processing;  // dall'estrazione alla distruzione
+} trace_snapshot_t;
+
+// contatori scritti da un solo thread, letti da trace_merge
+typedef struct trace_counters {
+    atomic_ullong counts[TRACE_BUCKETS];
+    atomic_ullong sum_ns;
+    atomic_ullong max_ns;
+} trace_counters_t;
+
+// istogrammi di un thread per un buffer
+typedef struct trace_thread {
+    pthread_t owner;
+    trace_counters_t queueing;
+    trace_counters_t processing;
+    struct trace_thread* next;
+} trace_thread_t;
+
+// stato del tracciamento di un buffer
+typedef struct trace {
+    _Atomic(trace_thread_t*) threads; // lista dei thread registrati, solo inserimenti in testa
+} trace_t;
+
+extern atomic_uint trace_sample_every;
+extern _Thread_local unsigned int trace_countdown;
+extern atomic_uint trace_inflight_count;
+
+// inizializzazione / deallocazione del tracciamento di un buffer;
+// N.B.: i messaggi estratti non ancora distrutti non verranno più misurati
+void trace_init(trace_t* trace);
+void trace_destroy(trace_t* trace);
+
+// campiona un inserimento ogni every in ogni thread; 0 disattiva
+void trace_set_sampling(unsigned int every);
+
+// somma gli istogrammi di tutti i thread del buffer
+void trace_merge(trace_t* trace, trace_snapshot_t* snapshot);
+
+// latenza (limite superiore dell'intervallo) sotto cui cade la
+// percentuale percentile dei campioni; 0 se l'istogramma è vuoto
+uint64_t trace_percentile(const trace_histogram_t* histogram, double percentile);
+
+// istante corrente in nanosecondi, mai 0
+uint64_t trace_now(void);
+
+void trace_record_dequeue(trace_t* trace, uint64_t stamp, msg_t* msg);
+void trace_record_destroy(msg_t* msg);
+
+// aggancio all'inserimento: istante da associare al messaggio, 0 se non campionato
+static inline uint64_t trace_enqueue(void) {
+    unsigned int every = atomic_load_explicit(&trace_sample_every, memory_order_relaxed);
+
+    if (every == 0) {
+        return 0;
+    }
+    if (trace_countdown > 1) {
+        trace_countdown--;
+        return 0;
+    }
+    trace_countdown = every;
+    return trace_now();
+}
+
+// aggancio all'estrazione: registra l'attesa se il messaggio era campionato
+static inline void trace_dequeue(trace_t* trace, uint64_t* stamp, msg_t* msg) {
+    if (*stamp != 0) {
+        trace_record_dequeue(trace, *stamp, msg);
+        *stamp = 0;
+    }
+}
+
+// aggancio alla distruzione: registra l'elaborazione se il messaggio era
+// campionato; N.B.: va chiamato da ogni msg_destroy, anche di tipi di
+// messaggio definiti dall'utente, altrimenti un messaggio allocato poi
+// allo stesso indirizzo può ereditarne la misura (entro 10 s)
+static inline void trace_msg_destroyed(msg_t* msg) {
+    if (atomic_load_explicit(&trace_inflight_count, memory_order_relaxed) > 0) {
+        trace_record_destroy(msg);
+    }
+}
+
+#else // BUFFER_TRACE
+
+static inline void trace_msg_destroyed(msg_t* msg) {
+    (void) msg;
+}
+
+#endif // BUFFER_TRACE
+
+#endif // TRACE_H